@@ -0,0 +1,676 @@
+;
+; This file is part of BASICfuck.
+;
+; Copyright (c) 2024-2025 ona-li-toki-e-jan-Epiphany-tawa-mi
+;
+; BASICfuck is free software: you can redistribute it and/or modify it under
+; the terms of the GNU General Public License as published by the Free Software
+; Foundation, either version 3 of the License, or (at your option) any later
+; version.
+;
+; BASICfuck is distributed in the hope that it will be useful, but WITHOUT ANY
+; WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+; A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+;
+; You should have received a copy of the GNU General Public License along with
+; BASICfuck. If not, see <https://www.gnu.org/licenses/>.
+;
+
+;
+; BASICfuck bytecode interpreter, written in assembly for speed.
+;
+; Runs the exact same bytecode as interpret() in baf-repl.c, which wraps this
+; when built with ASSEMBLY_INTERPRETER defined. The interpreter state is kept in
+; cc65's register variable bank, in the same layout used by native code, so the
+; native code helpers can be called from here unchanged.
+;
+
+        .include "zeropage.inc"
+
+        .export _interpretAssembly
+
+; BASICfuck memory pointer.
+bfmem   = regbank
+; Computer memory pointer.
+cmem    = regbank+2
+; Program pointer.
+pc      = regbank+4
+
+; Offsets into the parameters given by the C code. Must match the layout of
+; assembly_interpreter_parameters_t in baf-repl.c.
+PARAMETER_PROGRAM        = 0
+PARAMETER_BFMEM_START    = 2
+PARAMETER_BFMEM_END      = 4
+PARAMETER_BFMEM_MOVE_END = 6
+PARAMETER_PRINT          = 8
+PARAMETER_INPUT          = 10
+PARAMETER_POLL_STOP      = 12
+PARAMETER_EXECUTE        = 14
+PARAMETER_OUT_OF_BOUNDS  = 16
+PARAMETER_CLEAN          = 18
+PARAMETER_STOP_KEY       = 20
+
+; How many times to loop back before checking for STOP. Must match
+; STOP_POLL_INTERVAL in baf-repl.c.
+STOP_POLL_INTERVAL    = 16
+
+; Copies a word from the parameters, pointed to by ptr1, to an address.
+.macro  copy_parameter offset, address
+        ldy     #offset
+        lda     (ptr1),y
+        sta     address
+        iny
+        lda     (ptr1),y
+        sta     address+1
+.endmacro
+
+.bss
+
+; The start of BASICfuck memory.
+bfmem_start:    .res 2
+; One after the end of BASICfuck memory.
+bfmem_end:      .res 2
+; The pointer is kept before this, which is moved further by the clean helper,
+; as more of BASICfuck memory is cleared, until it reaches bfmem_end.
+bfmem_move_end: .res 2
+; The number of times left to loop back before checking for STOP.
+poll_countdown: .res 1
+; The next character to print, and how many are left, for
+; OPCODE_PRINT_STRING. Kept here since the print helper clobbers the zero page
+; temporaries.
+string_pointer: .res 2
+string_count:   .res 1
+
+.code
+
+; void __fastcall__ interpretAssembly(
+;     const assembly_interpreter_parameters_t* parameters);
+; Runs the bytecode-compiled BASICfuck program given in the parameters.
+; regbank+0,1 - the current BASICfuck memory pointer.
+; regbank+2,3 - the current computer memory pointer.
+; regbank+4,5 - clobbered.
+_interpretAssembly:
+        sta     ptr1
+        stx     ptr1+1
+
+        copy_parameter PARAMETER_PROGRAM,        pc
+        copy_parameter PARAMETER_BFMEM_START,    bfmem_start
+        copy_parameter PARAMETER_BFMEM_END,      bfmem_end
+        copy_parameter PARAMETER_BFMEM_MOVE_END, bfmem_move_end
+        ; The C helpers are called by overwriting the addresses of the
+        ; subroutine calls to them.
+        copy_parameter PARAMETER_PRINT,          print_jump+1
+        copy_parameter PARAMETER_INPUT,          input_call+1
+        copy_parameter PARAMETER_POLL_STOP,      poll_stop+1
+        copy_parameter PARAMETER_EXECUTE,        execute_call+1
+        copy_parameter PARAMETER_OUT_OF_BOUNDS,  out_of_bounds_call+1
+        copy_parameter PARAMETER_CLEAN,          clean_call+1
+        ldy     #PARAMETER_STOP_KEY
+        lda     (ptr1),y
+        sta     stop_key_compare+1
+        lda     #STOP_POLL_INTERVAL
+        sta     poll_countdown
+
+        jmp     dispatch
+
+; Jumped to after an opcode has been executed, to move past it.
+next3:  lda     #3
+        bne     advance
+next2:  lda     #2
+        bne     advance
+next1:  lda     #1
+advance:
+        clc
+        adc     pc
+        sta     pc
+        bcc     dispatch
+        inc     pc+1
+
+        ; Jumps to the routine for the current opcode by pushing its address
+        ; and returning to it, with the first argument in A and Y = 1.
+dispatch:
+        ldy     #0
+        lda     (pc),y
+        asl     a
+        tax
+        lda     jump_table+1,x
+        pha
+        lda     jump_table,x
+        pha
+        iny
+        lda     (pc),y
+        rts
+
+; Stops the program because an instruction would move outside of memory. The
+; helper prints the message.
+out_of_bounds:
+out_of_bounds_call:
+        jmp     $FFFF
+
+; Returns non-zero in A if STOP was pressed.
+poll_stop:
+        jmp     $FFFF
+
+; Prints the character in A. Y must be reset to 0 afterwards.
+print:  ldx     #0
+print_jump:
+        jmp     $FFFF
+
+; Clears more of memory, so the pointer can be moved to the cell at A (high
+; byte) and X (low byte,) which is past bfmem_move_end. Returns with the carry
+; clear if all of it already was, otherwise the instruction should be run again.
+clean:  ldy     bfmem_move_end
+        cpy     bfmem_end
+        bne     @clean
+        ldy     bfmem_move_end+1
+        cpy     bfmem_end+1
+        bne     @clean
+        clc
+        rts
+@clean: stx     tmp1
+        tax
+        lda     tmp1
+clean_call:
+        jsr     $FFFF
+        sta     bfmem_move_end
+        stx     bfmem_move_end+1
+        sec
+        rts
+
+; Points ptr1 at the cell at the signed offset in A from the current one.
+; Returns with the carry set if that cell is outside of memory.
+offset_cell:
+        ldx     #0
+        cmp     #$80
+        bcc     @positive
+        dex
+@positive:
+        clc
+        adc     bfmem
+        sta     ptr1
+        txa
+        adc     bfmem+1
+        sta     ptr1+1
+
+        cmp     bfmem_start+1
+        bcc     @outside
+        bne     @above_start
+        lda     ptr1
+        cmp     bfmem_start
+        bcc     @outside
+@above_start:
+        lda     ptr1+1
+        cmp     bfmem_end+1
+        bcc     @inside
+        bne     @outside
+        lda     ptr1
+        cmp     bfmem_end
+@inside:
+        rts
+@outside:
+        sec
+        rts
+
+; The addresses, minus one, of the routine for each opcode.
+jump_table:
+        .word   opcode_halt-1                  ; OPCODE_HALT.
+        .word   opcode_increment-1             ; OPCODE_INCREMENT.
+        .word   opcode_decrement-1             ; OPCODE_DECREMENT.
+        .word   opcode_bfmem_left-1            ; OPCODE_BFMEM_LEFT.
+        .word   opcode_bfmem_right-1           ; OPCODE_BFMEM_RIGHT.
+        .word   opcode_print-1                 ; OPCODE_PRINT.
+        .word   opcode_input-1                 ; OPCODE_INPUT.
+        .word   opcode_jeq-1                   ; OPCODE_JEQ.
+        .word   opcode_jne-1                   ; OPCODE_JNE.
+        .word   opcode_cmem_read-1             ; OPCODE_CMEM_READ.
+        .word   opcode_cmem_write-1            ; OPCODE_CMEM_WRITE.
+        .word   opcode_cmem_left-1             ; OPCODE_CMEM_LEFT.
+        .word   opcode_cmem_right-1            ; OPCODE_CMEM_RIGHT.
+        .word   opcode_execute-1               ; OPCODE_EXECUTE.
+        .word   opcode_set_zero-1              ; OPCODE_SET_ZERO.
+        .word   opcode_multiply_add-1          ; OPCODE_MULTIPLY_ADD.
+        .word   opcode_scan_left-1             ; OPCODE_SCAN_LEFT.
+        .word   opcode_scan_right-1            ; OPCODE_SCAN_RIGHT.
+        .word   opcode_add_at-1                ; OPCODE_ADD_AT.
+        .word   opcode_print_at-1              ; OPCODE_PRINT_AT.
+        .word   opcode_set_zero_at-1           ; OPCODE_SET_ZERO_AT.
+        .word   opcode_jeq_short-1             ; OPCODE_JEQ_SHORT.
+        .word   opcode_jne_short-1             ; OPCODE_JNE_SHORT.
+        .word   opcode_check_bounds-1          ; OPCODE_CHECK_BOUNDS.
+        .word   opcode_bfmem_left_unchecked-1  ; OPCODE_BFMEM_LEFT_UNCHECKED.
+        .word   opcode_bfmem_right_unchecked-1 ; OPCODE_BFMEM_RIGHT_UNCHECKED.
+        .word   opcode_print_string-1          ; OPCODE_PRINT_STRING.
+
+opcode_halt:
+        rts
+
+opcode_increment:
+        dey
+        clc
+        adc     (bfmem),y
+        sta     (bfmem),y
+        jmp     next2
+
+opcode_decrement:
+        sta     tmp1
+        dey
+        lda     (bfmem),y
+        sec
+        sbc     tmp1
+        sta     (bfmem),y
+        jmp     next2
+
+opcode_bfmem_left:
+        sta     tmp1
+        lda     bfmem
+        sec
+        sbc     tmp1
+        tax
+        lda     bfmem+1
+        sbc     #0
+        bcc     @outside
+        cmp     bfmem_start+1
+        bcc     @outside
+        bne     @move
+        cpx     bfmem_start
+        bcc     @outside
+@move:  stx     bfmem
+        sta     bfmem+1
+        jmp     next2
+@outside:
+        jmp     out_of_bounds
+
+opcode_bfmem_right:
+        clc
+        adc     bfmem
+        tax
+        lda     bfmem+1
+        adc     #0
+        bcs     @outside
+        cmp     bfmem_move_end+1
+        bcc     @move
+        bne     @clean
+        cpx     bfmem_move_end
+        bcs     @clean
+@move:  stx     bfmem
+        sta     bfmem+1
+        jmp     next2
+@clean: jsr     clean
+        bcc     @outside
+        jmp     dispatch
+@outside:
+        jmp     out_of_bounds
+
+; Stops the program if the loop after it would move outside of memory.
+opcode_check_bounds:
+        sta     tmp1
+        dey
+        lda     (bfmem),y
+        beq     @done
+        ; Needs bfmem - argument1 >= bfmem_start.
+        lda     bfmem
+        sec
+        sbc     tmp1
+        tax
+        lda     bfmem+1
+        sbc     #0
+        bcc     @outside
+        cmp     bfmem_start+1
+        bcc     @outside
+        bne     @check_right
+        cpx     bfmem_start
+        bcc     @outside
+@check_right:
+        ; Needs bfmem + argument2 < bfmem_move_end.
+        ldy     #2
+        lda     (pc),y
+        clc
+        adc     bfmem
+        tax
+        lda     bfmem+1
+        adc     #0
+        bcs     @outside
+        cmp     bfmem_move_end+1
+        bcc     @done
+        bne     @clean
+        cpx     bfmem_move_end
+        bcs     @clean
+@done:  jmp     next3
+@clean: jsr     clean
+        bcc     @outside
+        jmp     dispatch
+@outside:
+        jmp     out_of_bounds
+
+opcode_bfmem_left_unchecked:
+        sta     tmp1
+        lda     bfmem
+        sec
+        sbc     tmp1
+        sta     bfmem
+        bcs     @done
+        dec     bfmem+1
+@done:  jmp     next2
+
+opcode_bfmem_right_unchecked:
+        clc
+        adc     bfmem
+        sta     bfmem
+        bcc     @done
+        inc     bfmem+1
+@done:  jmp     next2
+
+opcode_print:
+        dey
+        lda     (bfmem),y
+        jsr     print
+        jmp     next1
+
+; Aborts if the key was STOP. The helper prints the message.
+opcode_input:
+input_call:
+        jsr     $FFFF
+stop_key_compare:
+        cmp     #$FF
+        bne     @store
+        rts
+@store: ldy     #0
+        sta     (bfmem),y
+        jmp     next1
+
+; Both jumps land on the other instruction of the loop, which is then moved
+; past.
+opcode_jeq:
+        dey
+        lda     (bfmem),y
+        beq     jump
+        jmp     next3
+
+; Checking for STOP is done only when looping back, and even then only every so
+; often, to keep it off of the path of most instructions.
+opcode_jne:
+        dey
+        lda     (bfmem),y
+        bne     @loop_back
+        jmp     next3
+@loop_back:
+        dec     poll_countdown
+        bne     jump
+        lda     #STOP_POLL_INTERVAL
+        sta     poll_countdown
+        jsr     poll_stop
+        tax
+        beq     jump
+        rts
+
+jump:   ldy     #1
+        lda     (pc),y
+        tax
+        iny
+        lda     (pc),y
+        stx     pc
+        sta     pc+1
+        jmp     next3
+
+; Like the long jumps, but hold the signed distance to the other instruction.
+opcode_jeq_short:
+        tax
+        dey
+        lda     (bfmem),y
+        beq     short_jump
+        jmp     next2
+
+opcode_jne_short:
+        tax
+        dey
+        lda     (bfmem),y
+        bne     @loop_back
+        jmp     next2
+@loop_back:
+        dec     poll_countdown
+        bne     short_jump
+        lda     #STOP_POLL_INTERVAL
+        sta     poll_countdown
+        txa
+        pha
+        jsr     poll_stop
+        tay
+        pla
+        tax
+        cpy     #0
+        beq     short_jump
+        rts
+
+; Adds the signed distance in X to the program pointer.
+short_jump:
+        txa
+        ldx     #0
+        cmp     #$80
+        bcc     @forward
+        dex
+@forward:
+        clc
+        adc     pc
+        sta     pc
+        txa
+        adc     pc+1
+        sta     pc+1
+        jmp     next2
+
+opcode_cmem_read:
+        dey
+        lda     (cmem),y
+        sta     (bfmem),y
+        jmp     next1
+
+opcode_cmem_write:
+        dey
+        lda     (bfmem),y
+        sta     (cmem),y
+        jmp     next1
+
+; Stops at $0000.
+opcode_cmem_left:
+        sta     tmp1
+        lda     cmem
+        sec
+        sbc     tmp1
+        tax
+        lda     cmem+1
+        sbc     #0
+        bcs     @move
+        lda     #0
+        tax
+@move:  stx     cmem
+        sta     cmem+1
+        jmp     next2
+
+; Stops at $FFFF.
+opcode_cmem_right:
+        clc
+        adc     cmem
+        tax
+        lda     cmem+1
+        adc     #0
+        bcc     @move
+        lda     #$FF
+        tax
+@move:  stx     cmem
+        sta     cmem+1
+        jmp     next2
+
+; The helper returns zero in A, without running it, if the registers would come
+; from outside of memory.
+opcode_execute:
+execute_call:
+        jsr     $FFFF
+        tax
+        beq     @outside
+        jmp     next1
+@outside:
+        jmp     out_of_bounds
+
+opcode_set_zero:
+        dey
+        tya
+        sta     (bfmem),y
+        jmp     next1
+
+; Multiplies with shifts and adds. The loop this replaced doesn't run when the
+; current cell is 0, so it can only leave memory when it isn't.
+opcode_multiply_add:
+        jsr     offset_cell
+        bcs     @outside
+        ldy     #2
+        lda     (pc),y
+        sta     tmp1
+        ldy     #0
+        lda     (bfmem),y
+        sta     tmp2
+        tya
+        ldx     #8
+@multiply:
+        lsr     tmp1
+        bcc     @skip_add
+        clc
+        adc     tmp2
+@skip_add:
+        asl     tmp2
+        dex
+        bne     @multiply
+        clc
+        adc     (ptr1),y
+        sta     (ptr1),y
+@done:  jmp     next3
+@outside:
+        ldy     #0
+        lda     (bfmem),y
+        beq     @done
+        jmp     out_of_bounds
+
+opcode_add_at:
+        jsr     offset_cell
+        bcs     @outside
+        ldy     #2
+        lda     (pc),y
+        ldy     #0
+        clc
+        adc     (ptr1),y
+        sta     (ptr1),y
+        jmp     next3
+@outside:
+        jmp     out_of_bounds
+
+opcode_print_at:
+        jsr     offset_cell
+        bcs     @outside
+        ldy     #0
+        lda     (ptr1),y
+        jsr     print
+        jmp     next2
+@outside:
+        jmp     out_of_bounds
+
+opcode_set_zero_at:
+        jsr     offset_cell
+        bcs     @outside
+        lda     #0
+        tay
+        sta     (ptr1),y
+        jmp     next2
+@outside:
+        jmp     out_of_bounds
+
+opcode_scan_left:
+        sta     tmp1
+        clc
+        lda     bfmem_start
+        adc     tmp1
+        sta     ptr1
+        lda     bfmem_start+1
+        adc     #0
+        sta     ptr1+1
+        dey
+@loop:  lda     (bfmem),y
+        beq     @done
+        ; Stops once the pointer is less than the stride from the start.
+        lda     bfmem+1
+        cmp     ptr1+1
+        bcc     @stuck
+        bne     @move
+        lda     bfmem
+        cmp     ptr1
+        bcc     @stuck
+@move:  lda     bfmem
+        sec
+        sbc     tmp1
+        sta     bfmem
+        bcs     @loop
+        dec     bfmem+1
+        jmp     @loop
+@stuck: jmp     out_of_bounds
+@done:  jmp     next2
+
+opcode_scan_right:
+        sta     tmp1
+        sec
+        lda     bfmem_move_end
+        sbc     tmp1
+        sta     ptr1
+        lda     bfmem_move_end+1
+        sbc     #0
+        sta     ptr1+1
+        dey
+@loop:  lda     (bfmem),y
+        beq     @done
+        ; Stops once the pointer is within the stride from the end.
+        lda     bfmem+1
+        cmp     ptr1+1
+        bcc     @move
+        bne     @stuck
+        lda     bfmem
+        cmp     ptr1
+        bcs     @stuck
+@move:  lda     bfmem
+        clc
+        adc     tmp1
+        sta     bfmem
+        bcc     @loop
+        inc     bfmem+1
+        jmp     @loop
+        ; Carries on once more memory is cleared.
+@stuck: lda     bfmem
+        clc
+        adc     tmp1
+        tax
+        lda     bfmem+1
+        adc     #0
+        jsr     clean
+        bcs     @clean
+        jmp     out_of_bounds
+@clean: jmp     dispatch
+@done:  jmp     next2
+
+; Prints argument3 characters, starting at the address in argument1,2.
+opcode_print_string:
+        sta     string_pointer
+        iny
+        lda     (pc),y
+        sta     string_pointer+1
+        iny
+        lda     (pc),y
+        sta     string_count
+@loop:  lda     string_pointer
+        sta     ptr1
+        lda     string_pointer+1
+        sta     ptr1+1
+        ldy     #0
+        lda     (ptr1),y
+        jsr     print
+        inc     string_pointer
+        bne     @next
+        inc     string_pointer+1
+@next:  dec     string_count
+        bne     @loop
+        lda     #4
+        jmp     advance
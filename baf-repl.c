@@ -21,11 +21,37 @@
  *
  * Preprocessor parameters:
  * - BASICFUCK_MEMORY_SIZE - The number of BASICfuck cells (bytes) to allocate.
- * - HISTORY_STACK_SIZE - The size, in bytes, of the history stack.
+ * - HISTORY_STACK_SIZE - The size, in bytes, of the history stack, not
+ *   counting its index. Must be at least 255.
+ * - NATIVE_MEMORY_SIZE - The size, in bytes, of the buffer for natively
+ *   compiled BASICfuck programs.
+ * - PROGRAM_MEMORY_SIZE - The size, in bytes, of the buffer for compiled
+ *   BASICfuck bytecode.
+ * - PROGRAM_STORE_SIZE - The size, in bytes, of the store for the lines of the
+ *   program run with RUN, and their bytecode.
+ * - BYTECODE_CACHE_SIZE - The size, in bytes, of the cache of the compiled
+ *   bytecode of recently run lines.
+ * - TYPE_AHEAD_SIZE - The number of keys the type-ahead buffer holds. Must be a
+ *   power of two, no larger than 256.
+ * - CELL_WIDTH - The size, in bits, of BASICfuck cells. Must be 8 or 16. Native
+ *   code and the interpreter in baf-interpreter.s are only for 8-bit cells.
+ * - BANKED_TAPE - If defined, extends BASICfuck memory into the extended memory
+ *   of the C128, Commander X16, or Atari XL (or, emulated, the host computer.)
+ *   Requires the interpreter written in C. Native code is not generated.
+ * - ASSEMBLY_INTERPRETER - If defined, uses the interpreter in
+ *   baf-interpreter.s, which must be linked in, instead of the one written in
+ *   C.
+ * - PROFILER - If defined, the interpreter counts how many times each
+ *   instruction runs, which can be viewed with the 'P' command. Native code
+ *   starts off, since it isn't counted. Requires the interpreter written in C.
+ * - BENCHMARK - If defined, runs the program defined in benchmark.h, which must
+ *   be on the include path, instead of the REPL, timing it and writing the
+ *   results to a file. Used by "build.sh bench".
  */
 
 #include <assert.h>
 #include <conio.h>
+#include <fcntl.h>
 #include <limits.h>
 #include <stdbool.h>
 #include <stddef.h>
@@ -34,6 +60,33 @@
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
+#ifdef BENCHMARK
+#include <time.h>
+#endif
+
+#if defined(PROFILER) && defined(ASSEMBLY_INTERPRETER)
+#error "PROFILER requires the interpreter written in C"
+#endif
+#if 8 != CELL_WIDTH && 16 != CELL_WIDTH
+#error "CELL_WIDTH must be 8 or 16"
+#endif
+#if 16 == CELL_WIDTH && defined(ASSEMBLY_INTERPRETER)
+#error "16-bit cells require the interpreter written in C"
+#endif
+#if defined(BANKED_TAPE) && defined(ASSEMBLY_INTERPRETER)
+#error "BANKED_TAPE requires the interpreter written in C"
+#endif
+
+// Native code is only generated for 8-bit cells in main memory.
+#if defined(__CC65__) && 8 == CELL_WIDTH && !defined(BANKED_TAPE)
+#  define NATIVE_CODE
+#endif
+
+#ifndef __CC65__
+// Lets everything that isn't specific to the 6502 build with other compilers,
+// for running on the host computer. See host/conio.h.
+#  define __fastcall__
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////
 // Utilities                                                                   //
@@ -115,10 +168,185 @@ static uint8_t wrappedCgetc(void) {
 #  define KEYBOARD_F2           CH_F2
 #  define KEYBOARD_F2_STRING    "F2 (ATARI+2)"
 
-#else // __ATARI__
+#elif !defined(__CC65__) // __ATARI__
+// The host conio shim translates terminal keys into these.
+#  define KEYBOARD_UP           CH_CURS_UP
+#  define KEYBOARD_DOWN         CH_CURS_DOWN
+#  define KEYBOARD_LEFT         CH_CURS_LEFT
+#  define KEYBOARD_RIGHT        CH_CURS_RIGHT
+#  define KEYBOARD_BACKSPACE    CH_DEL
+#  define KEYBOARD_INSERT       CH_INS
+#  define KEYBOARD_ENTER        CH_ENTER
+#  define KEYBOARD_STOP         CH_STOP
+#  define KEYBOARD_STOP_STRING  "CTRL+C"
+#  define KEYBOARD_HOME         CH_HOME
+#  define KEYBOARD_HOME_STRING  "HOME"
+#  define KEYBOARD_CLEAR        CH_CLR
+#  define KEYBOARD_CLEAR_STRING "CTRL+L"
+#  define KEYBOARD_F1           CH_F1
+#  define KEYBOARD_F1_STRING    "F1"
+#  define KEYBOARD_F2           CH_F2
+#  define KEYBOARD_F2_STRING    "F2"
+
+#else // !__CC65__
 #  error build target not supported
 #endif // #else
 
+////////////////////////////////////////////////////////////////////////////////
+// Type-ahead                                                                 //
+////////////////////////////////////////////////////////////////////////////////
+
+#if 0 != (TYPE_AHEAD_SIZE & (TYPE_AHEAD_SIZE - 1)) || TYPE_AHEAD_SIZE > 256
+#  error TYPE_AHEAD_SIZE must be a power of two, no larger than 256
+#endif
+
+// Keys pressed while a program is running, waiting to be read by ','. Keys are
+// added at the head and taken from the tail, with one slot always left empty
+// to tell a full buffer from an empty one.
+// STOP is never placed in the buffer, and instead sets type_ahead_stop, so it
+// is seen right away instead of after the keys before it.
+static uint8_t          type_ahead_buffer[TYPE_AHEAD_SIZE] = {0};
+static volatile uint8_t type_ahead_head                    = 0;
+static volatile uint8_t type_ahead_tail                    = 0;
+static volatile bool    type_ahead_stop                    = false;
+
+// Adds a key to the type-ahead buffer, or, if it's STOP, sets type_ahead_stop.
+// Keys are dropped if the buffer is full.
+// type_ahead_buffer, type_ahead_head, type_ahead_tail, type_ahead_stop (global)
+// - the type-ahead buffer.
+static void __fastcall__ typeAheadPush(const uint8_t key) {
+    uint8_t next_head = 0;
+
+    if (KEYBOARD_STOP == key) {
+        type_ahead_stop = true;
+        return;
+    }
+
+    next_head = (type_ahead_head + 1) & (TYPE_AHEAD_SIZE - 1);
+    if (next_head == type_ahead_tail) return;
+    type_ahead_buffer[type_ahead_head] = key;
+    type_ahead_head                    = next_head;
+}
+
+// The system's keyboard buffer, and the number of keys in it, on the computers
+// where the type-ahead buffer is filled from an interrupt. Everywhere else, it
+// is filled whenever the program checks for STOP.
+#if defined(__C64__)
+#  define SYSTEM_KEYBOARD_BUFFER ((volatile uint8_t*)0x0277)
+#  define SYSTEM_KEYBOARD_COUNT  (*(volatile uint8_t*)0x00C6)
+#elif defined(__C128__)
+#  define SYSTEM_KEYBOARD_BUFFER ((volatile uint8_t*)0x034A)
+#  define SYSTEM_KEYBOARD_COUNT  (*(volatile uint8_t*)0x00D0)
+#elif defined(__C16__)
+#  define SYSTEM_KEYBOARD_BUFFER ((volatile uint8_t*)0x0527)
+#  define SYSTEM_KEYBOARD_COUNT  (*(volatile uint8_t*)0x00EF)
+#elif defined(__PET__)
+#  define SYSTEM_KEYBOARD_BUFFER ((volatile uint8_t*)0x026F)
+#  define SYSTEM_KEYBOARD_COUNT  (*(volatile uint8_t*)0x009E)
+#endif
+
+#ifdef SYSTEM_KEYBOARD_BUFFER
+#  include <6502.h>
+
+// Whether typeAheadInterrupt() should move keys into the type-ahead buffer.
+// Only set while a program is running, so the REPL's own input is untouched.
+static volatile bool type_ahead_enabled = false;
+
+// The C stack used while running typeAheadInterrupt().
+static uint8_t type_ahead_interrupt_stack[64] = {0};
+
+// Runs on every interrupt, just before the system's handler, which will have
+// already scanned the keyboard on the last one. Moves the keys from the
+// system's keyboard buffer into the type-ahead buffer, which is larger, and,
+// unlike the system's buffer, doesn't need the program to stop for it to be
+// emptied.
+// type_ahead_enabled (global) - whether to move keys.
+static uint8_t typeAheadInterrupt(void) {
+    uint8_t i = 0;
+
+    if (type_ahead_enabled) {
+        for (; i < SYSTEM_KEYBOARD_COUNT; ++i) {
+            typeAheadPush(SYSTEM_KEYBOARD_BUFFER[i]);
+        }
+        SYSTEM_KEYBOARD_COUNT = 0;
+    }
+
+    return IRQ_NOT_HANDLED;
+}
+#endif // SYSTEM_KEYBOARD_BUFFER
+
+// A one-time-call function used to initialize the type-ahead buffer.
+// deinitializeTypeAhead() must be called before exiting.
+static void initializeTypeAhead(void) {
+#ifdef SYSTEM_KEYBOARD_BUFFER
+    set_irq(
+        &typeAheadInterrupt,
+        type_ahead_interrupt_stack,
+        sizeof(type_ahead_interrupt_stack)
+    );
+#endif
+}
+
+// Removes what initializeTypeAhead() set up.
+static void deinitializeTypeAhead(void) {
+#ifdef SYSTEM_KEYBOARD_BUFFER
+    reset_irq();
+#endif
+}
+
+// Empties the type-ahead buffer and starts filling it. Must be called before
+// running a program, and typeAheadEnd() after.
+static void typeAheadBegin(void) {
+    type_ahead_tail = type_ahead_head;
+    type_ahead_stop = false;
+#ifdef SYSTEM_KEYBOARD_BUFFER
+    type_ahead_enabled = true;
+#endif
+}
+
+// Stops filling the type-ahead buffer. Any keys still in it are dropped by the
+// next typeAheadBegin().
+static void typeAheadEnd(void) {
+#ifdef SYSTEM_KEYBOARD_BUFFER
+    type_ahead_enabled = false;
+#endif
+}
+
+// Returns true if STOP was pressed since the last call, clearing it. Where there
+// is no interrupt to fill the type-ahead buffer, this also moves any waiting
+// keys into it.
+static bool typeAheadStopPressed(void) {
+#ifndef SYSTEM_KEYBOARD_BUFFER
+    while (!type_ahead_stop && 0 != kbhit()) {
+        typeAheadPush(wrappedCgetc());
+    }
+#endif
+
+    if (type_ahead_stop) {
+        type_ahead_stop = false;
+        return true;
+    }
+    return false;
+}
+
+// Takes the next key from the type-ahead buffer, awaiting one if it's empty.
+// Returns KEYBOARD_STOP if STOP was pressed, even if there are other keys
+// waiting.
+static uint8_t typeAheadGet(void) {
+    uint8_t key = 0;
+
+    while (type_ahead_head == type_ahead_tail && !type_ahead_stop) {
+#ifndef SYSTEM_KEYBOARD_BUFFER
+        typeAheadPush(wrappedCgetc());
+#endif
+    }
+    if (typeAheadStopPressed()) return KEYBOARD_STOP;
+
+    key             = type_ahead_buffer[type_ahead_tail];
+    type_ahead_tail = (type_ahead_tail + 1) & (TYPE_AHEAD_SIZE - 1);
+    return key;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Text Buffers                                                               //
 ////////////////////////////////////////////////////////////////////////////////
@@ -148,34 +376,45 @@ static bool isControlCharacter(const uint8_t character) {
            (character >= 0x7D && character <= 0x7F) ||
            (character >= 0x8B && character <= 0x8F) ||
            character >= 0xFD;
+#elif !defined(__CC65__)
+    // ASCII character set, as seen through the host conio shim.
+    return character < 0x20 || character >= 0x7F;
 #else
 #  error build target not supported
 #endif
 }
 
+// Compressed inputs take at most 255 bytes, and must always fit once the older
+// ones are dropped.
+#if HISTORY_STACK_SIZE < 255
+#  error HISTORY_STACK_SIZE must be at least 255
+#endif
+
 // History stack state.
+// Past inputs, compressed, one after another from oldest to newest. Runs of
+// the same BASICfuck instruction are stored as HISTORY_RUN_MARKER, followed by
+// a byte with the number of the instruction in history_run_instructions[],
+// plus one, in the top 3 bits, and the length of the run, minus
+// HISTORY_MIN_RUN, in the bottom 5.
 static uint8_t  history_stack[HISTORY_STACK_SIZE] = {0};
-static uint16_t history_stack_index               = 0;
-
-// Increments the history stack index and loops it around if it goes out of
-// bounds.
-// history_stack_index (global) - current index into the history stack.
-static void incrementHistoryStackIndex(void) {
-    ++history_stack_index;
-    if (history_stack_index >= HISTORY_STACK_SIZE) {
-        history_stack_index = 0;
-    }
-}
-
-// Decrements the history stack index and loops it around if it goes out of
-// bounds.
-static void decrementHistoryStackIndex(void) {
-    if (0 == history_stack_index) {
-        history_stack_index = HISTORY_STACK_SIZE - 1;
-    } else {
-        --history_stack_index;
-    }
-}
+// The maximum number of inputs kept in the history stack.
+#define HISTORY_MAX_ENTRIES 64
+// Where each input starts in the history stack, with one more after the newest
+// for where the next will go.
+static uint16_t history_offsets[HISTORY_MAX_ENTRIES + 1] = {0};
+// The number of inputs in the history stack.
+static uint8_t  history_count                            = 0;
+// The input last recalled, or history_count if none have been since the last
+// one was saved.
+static uint8_t  history_recall_index                     = 0;
+
+// A control character on every target, so it is never typed in.
+#define HISTORY_RUN_MARKER 0x1F
+// The instructions that are compressed when repeated, and the shortest and
+// longest runs of them that are.
+static const char history_run_instructions[] = "+-><()";
+#define HISTORY_MIN_RUN 3
+#define HISTORY_MAX_RUN (HISTORY_MIN_RUN + 0x1F)
 
 // Edit buffer state.
 // The buffer currently being edited.
@@ -186,53 +425,93 @@ static uint8_t edit_buffer_cursor = 0;
 // How much of the buffer is taken up by the text typed by the user.
 static uint8_t edit_buffer_input_size = 0;
 
-// Saves the edit buffer to the history stack for later recollection.
-static void saveEditBuffer(void) {
-    uint8_t character    = 0;
-    uint8_t buffer_index = 0;
+// Compresses the text in the edit buffer for the history stack.
+// Returns the size of the compressed text, which is never larger than the
+// text.
+// output - where to write the compressed text, or NULL to only get its size.
+static uint8_t compressEditBuffer(uint8_t *const output) {
+    const uint8_t* text        = edit_buffer;
+    const char*    instruction = NULL;
+    uint8_t        size        = 0;
+    uint8_t        run         = 0;
+
+    while ('\0' != *text) {
+        instruction = strchr(history_run_instructions, *text);
+        run         = 1;
+        if (NULL != instruction) {
+            while (run < HISTORY_MAX_RUN && text[run] == *text) ++run;
+        }
 
-    if (NULL == edit_buffer[buffer_index]) {
-        return;
+        if (run >= HISTORY_MIN_RUN) {
+            if (NULL != output) {
+                output[size]     = HISTORY_RUN_MARKER;
+                output[size + 1] = (uint8_t)(
+                    (instruction - history_run_instructions + 1) << 5
+                    | (run - HISTORY_MIN_RUN)
+                );
+            }
+            size += 2;
+        } else {
+            run = 1;
+            if (NULL != output) output[size] = *text;
+            ++size;
+        }
+        text += run;
     }
 
-    do {
-        character                          = edit_buffer[buffer_index];
-        history_stack[history_stack_index] = character;
+    return size;
+}
+
+// Drops the oldest input from the history stack.
+static void dropOldestHistory(void) {
+    const uint16_t size = history_offsets[1];
+    uint8_t        i    = 0;
+
+    memmove(
+        history_stack,
+        history_stack + size,
+        history_offsets[history_count] - size
+    );
+    --history_count;
+    for (; i <= history_count; ++i) {
+        history_offsets[i] = history_offsets[i + 1] - size;
+    }
+}
 
-        incrementHistoryStackIndex();
-        ++buffer_index;
-    } while (NULL != character);
+// Saves the edit buffer to the history stack for later recollection, dropping
+// the oldest inputs to make room.
+static void saveEditBuffer(void) {
+    const uint8_t size = compressEditBuffer(NULL);
+
+    if (0 == size) return;
+
+    while (HISTORY_MAX_ENTRIES == history_count
+            || size > HISTORY_STACK_SIZE - history_offsets[history_count]) {
+        dropOldestHistory();
+    }
+
+    compressEditBuffer(history_stack + history_offsets[history_count]);
+    ++history_count;
+    history_offsets[history_count] = history_offsets[history_count - 1] + size;
+    history_recall_index           = history_count;
 }
 
 // Recalls, into the edit buffer, the previous input if foward_recall is false,
 // else recalls the next input from the history stack.
 static void recallEditBuffer(const bool forward_recall) {
-    uint8_t  character;
-    uint16_t final_history_index = history_stack_index;
+    const uint8_t* entry     = NULL;
+    const uint8_t* entry_end = NULL;
+    uint8_t        character = 0;
+    uint8_t        run       = 0;
 
-    // Moves forwards or backwards to the next block in the history stack.
+    // Moves forwards or backwards to the next input, if there is one.
     if (forward_recall) {
-        while (NULL != history_stack[history_stack_index])
-            incrementHistoryStackIndex();
-        incrementHistoryStackIndex();
-
+        if (history_recall_index + 1 >= history_count) return;
+        ++history_recall_index;
     } else {
-        decrementHistoryStackIndex();
-        do {
-            decrementHistoryStackIndex();
-        } while (NULL != history_stack[history_stack_index]);
-        incrementHistoryStackIndex();
-    }
-
-    // If a NULL is found at the next block, that means that it's at the end of
-    // the history buffer.
-    if (NULL == history_stack[history_stack_index]) {
-        history_stack_index = final_history_index;
-        return;
+        if (0 == history_recall_index) return;
+        --history_recall_index;
     }
-    // Preservers the index of this block as we will stay here in case of
-    // succesive movements through the history.
-    final_history_index = history_stack_index;
 
     // Navigates visual cursor to the end of the buffer.
     for (; edit_buffer_cursor < edit_buffer_input_size; ++edit_buffer_cursor)
@@ -243,23 +522,25 @@ static void recallEditBuffer(const bool forward_recall) {
         --edit_buffer_cursor;
     }
 
-    // Reads from history buffer into buffer.
-    while (true) {
-        character                       = history_stack[history_stack_index];
-        edit_buffer[edit_buffer_cursor] = character;
-        putchar(character);
-
-        if (NULL == character)
-            break;
+    // Decompresses from the history stack into the buffer.
+    entry     = history_stack + history_offsets[history_recall_index];
+    entry_end = history_stack + history_offsets[history_recall_index + 1];
+    while (entry < entry_end) {
+        character = *entry++;
+        run       = 1;
+        if (HISTORY_RUN_MARKER == character) {
+            character = history_run_instructions[(*entry >> 5) - 1];
+            run       = (*entry++ & 0x1F) + HISTORY_MIN_RUN;
+        }
 
-        incrementHistoryStackIndex();
-        ++edit_buffer_cursor;
+        for (; run > 0; --run) {
+            edit_buffer[edit_buffer_cursor] = character;
+            putchar(character);
+            ++edit_buffer_cursor;
+        }
     }
-    edit_buffer_input_size = edit_buffer_cursor;
-
-    // Restores history stack index to the start of the current block so that
-    // moving forwards and backwords works properly.
-    history_stack_index = final_history_index;
+    edit_buffer[edit_buffer_cursor] = '\0';
+    edit_buffer_input_size          = edit_buffer_cursor;
 }
 
 // Creates an editable text buffer, starting from the current position on the
@@ -282,7 +563,7 @@ static void editEditBuffer(void) {
         // Finalizes the buffer and exits from this function.
         case KEYBOARD_ENTER: {
             // Writes out null-terminator.
-            edit_buffer[edit_buffer_input_size] = NULL;
+            edit_buffer[edit_buffer_input_size] = '\0';
             // Navigates to then end of buffer if neccesary.
             while (edit_buffer_cursor < edit_buffer_input_size) {
                 putchar(KEYBOARD_RIGHT);
@@ -294,14 +575,14 @@ static void editEditBuffer(void) {
 
         // "Clears" the input buffer and exits from this function.
         case KEYBOARD_STOP: {
-            edit_buffer[0] = NULL;
+            edit_buffer[0] = '\0';
             putchar('\n');
             goto lquit_editing_buffer;
         }
 
         // Clears the screen and input buffer and exits from this function.
         case KEYBOARD_CLEAR: {
-            edit_buffer[0] = NULL;
+            edit_buffer[0] = '\0';
             clrscr();
             goto lquit_editing_buffer;
         }
@@ -423,11 +704,100 @@ lquit_editing_buffer:
     return;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Output                                                                     //
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef __CC65__
+// Whether to write output straight to the screen with conio, instead of going
+// through putchar() and the system's character output routine. That routine is
+// much slower, but is kept as a compatibility mode, since it is what the rest
+// of the system expects.
+static bool fast_output_enabled = true;
+// Where the next character will be written, kept here so that conio doesn't
+// have to be asked for it each time.
+static uint8_t output_x = 0;
+static uint8_t output_y = 0;
+#endif
+
+// Picks up the position of the cursor. Must be called before printing with the
+// functions below if anything else has printed since they were last used.
+static void outputSync(void) {
+#ifdef __CC65__
+    output_x = wherex();
+    output_y = wherey();
+#endif
+}
+
+// Prints a character. With fast output, only control characters, which the
+// system knows how to handle, and newlines at the bottom of the screen, which
+// the system scrolls the screen for, go through putchar().
+static void __fastcall__ outputCharacter(const uint8_t character) {
+#ifdef __CC65__
+    if (fast_output_enabled) {
+        if ('\n' != character) {
+            if (isControlCharacter(character)) {
+                putchar(character);
+                outputSync();
+                return;
+            }
+            // conio moves on to the next line by itself after the last column,
+            // but doesn't scroll.
+            cputc(character);
+            if (++output_x < width) return;
+        }
+
+        output_x = 0;
+        if (output_y < height - 1) {
+            gotoxy(0, ++output_y);
+        } else {
+            gotoxy(0, output_y);
+            putchar('\n');
+        }
+        return;
+    }
+#endif
+    putchar(character);
+}
+
+// Prints a string (no newline.)
+static void __fastcall__ outputString(const char* string) {
+    for (; '\0' != *string; ++string) outputCharacter(*string);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // BASICfuck                                                                  //
 ////////////////////////////////////////////////////////////////////////////////
 
+#if 16 == CELL_WIDTH
+typedef uint16_t cell_t;
+// The number of digits needed to show the value of a cell in decimal.
+#  define CELL_DIGITS 5
+// The size, in bytes, of opcode arguments that hold a value to add to a cell.
+#  define CELL_ARGUMENT_SIZE 2
+// Gets the cell-sized argument at the given location, 16-bit little-endian.
+#  define GET_CELL_ARGUMENT(argument)                                          \
+    ((argument)[0] | (cell_t)(argument)[1] << 8)
+// Writes a cell-sized argument at the compiler's write pointer.
+#  define WRITE_CELL_ARGUMENT(value)                                           \
+    (*(compiler_write_pointer++) = (uint8_t)(value),                           \
+     *(compiler_write_pointer++) = (uint8_t)((value) >> 8))
+// Whether the given amount can be added to a cell with a single
+// OPCODE_INCREMENT or OPCODE_DECREMENT, which only take 8-bit counts.
+#  define IS_COUNTED_AMOUNT(amount)                                            \
+    ((cell_t)((amount) + UINT8_MAX) <= 2 * UINT8_MAX)
+#else // 16 == CELL_WIDTH
+typedef uint8_t cell_t;
+#  define CELL_DIGITS 3
+#  define CELL_ARGUMENT_SIZE 1
+#  define GET_CELL_ARGUMENT(argument) ((argument)[0])
+#  define WRITE_CELL_ARGUMENT(value) (*(compiler_write_pointer++) = (value))
+#  define IS_COUNTED_AMOUNT(amount) true
+#endif
+
 typedef uint8_t opcode_t;
+// Instructions that would move to, or work on, a cell outside of BASICfuck
+// memory stop the program with "?OUT OF BOUNDS" instead.
 // Ends the current BASICfuck program.
 #define OPCODE_HALT 0x00
 // Increments the current cell.
@@ -436,10 +806,12 @@ typedef uint8_t opcode_t;
 // Decrements the current cell.
 // argument1 - the amount to decrement by.
 #define OPCODE_DECREMENT 0x02
-// Moves the the cell pointer to the left.
+// Moves the the cell pointer to the left. Stops the program if that would leave
+// BASICfuck memory.
 // argument1 - the number of times to move to the left.
 #define OPCODE_BFMEM_LEFT 0x03
-// Moves the the cell pointer to the right.
+// Moves the the cell pointer to the right. Stops the program if that would
+// leave BASICfuck memory.
 // argument1 - the number of times to move to the right.
 #define OPCODE_BFMEM_RIGHT 0x04
 // Prints the value in the current cell as PETSCII character.
@@ -464,8 +836,69 @@ typedef uint8_t opcode_t;
 // argument1 - the number of times to move to the right.
 #define OPCODE_CMEM_RIGHT 0x0C
 // Runs the subroutine at the computer memory pointer with the current and next
-// two cells as the values for the X, Y, and Z registers.
+// two cells as the values for the X, Y, and Z registers. With 16-bit cells, only
+// the low byte of each cell is used, and the results are stored back as values
+// from 0 to 255.
 #define OPCODE_EXECUTE 0x0D
+// Sets the current cell to 0.
+#define OPCODE_SET_ZERO 0x0E
+// Adds the value of the current cell, multiplied by a factor, to the cell at an
+// offset from it. Stops the program if that cell is outside of BASICfuck memory
+// and the current cell isn't 0, since the loop it replaced wouldn't have run.
+// argument1 - the signed offset of the cell to add to.
+// argument2(,3) - the factor to multiply by, the size of a cell, 16-bit
+// little-endian for 16-bit cells.
+#define OPCODE_MULTIPLY_ADD 0x0F
+// Moves the cell pointer to the left until it lands on a cell that is 0. Stops
+// the program if that would leave BASICfuck memory.
+// argument1 - the number of cells to move by each time.
+#define OPCODE_SCAN_LEFT 0x10
+// Moves the cell pointer to the right until it lands on a cell that is 0. Stops
+// the program if that would leave BASICfuck memory.
+// argument1 - the number of cells to move by each time.
+#define OPCODE_SCAN_RIGHT 0x11
+// Adds to the cell at an offset from the current one. Stops the program if that
+// cell is outside of BASICfuck memory.
+// argument1 - the signed offset of the cell to add to.
+// argument2(,3) - the amount to add, the size of a cell, 16-bit little-endian
+// for 16-bit cells.
+#define OPCODE_ADD_AT 0x12
+// Prints the value in the cell at an offset from the current one as a PETSCII
+// character. Stops the program if that cell is outside of BASICfuck memory.
+// argument1 - the signed offset of the cell to print.
+#define OPCODE_PRINT_AT 0x13
+// Sets the cell at an offset from the current one to 0. Stops the program if
+// that cell is outside of BASICfuck memory.
+// argument1 - the signed offset of the cell to set.
+#define OPCODE_SET_ZERO_AT 0x14
+// Jumps to the accompanying OPCODE_JNE_SHORT if the current cell is 0. Used
+// instead of OPCODE_JEQ for loops short enough to reach with an 8-bit offset.
+// argument1 - the signed distance in program memory to jump by.
+#define OPCODE_JEQ_SHORT 0x15
+// Jumps to the accompanying OPCODE_JEQ_SHORT if the current cell is not 0.
+// argument1 - the signed distance in program memory to jump by.
+#define OPCODE_JNE_SHORT 0x16
+// Stops the program if the current cell is not 0 and the cell pointer is too
+// close to either edge of BASICfuck memory. Placed before loops that always
+// end up back where they started, and never move further than argument1 and
+// argument2, which use the unchecked moves below.
+// argument1 - the number of cells needed to the left.
+// argument2 - the number of cells needed to the right.
+#define OPCODE_CHECK_BOUNDS 0x17
+// Moves the cell pointer to the left, without checking for the start of
+// BASICfuck memory.
+// argument1 - the number of times to move to the left.
+#define OPCODE_BFMEM_LEFT_UNCHECKED 0x18
+// Moves the cell pointer to the right, without checking for the end of
+// BASICfuck memory.
+// argument1 - the number of times to move to the right.
+#define OPCODE_BFMEM_RIGHT_UNCHECKED 0x19
+// Prints a string of PETSCII characters, which is kept in program memory after
+// the end of the program.
+// argument1,2 - the address in program memory of the string, stored like the
+// address of a jump.
+// argument3 - the number of characters to print, which must not be 0.
+#define OPCODE_PRINT_STRING 0x1A
 
 // A table mapping from opcodes to their size (opcode + arguments) in bytes.
 // Index value must be valid opcode.
@@ -483,8 +916,23 @@ static const uint8_t opcode_size_table[] = {
     1, // OPCODE_CMEM_WRITE.
     2, // OPCODE_CMEM_LEFT.
     2, // OPCODE_CMEM_RIGHT.
-    1  // OPCODE_EXECUTE.
+    1, // OPCODE_EXECUTE.
+    1, // OPCODE_SET_ZERO.
+    2 + CELL_ARGUMENT_SIZE, // OPCODE_MULTIPLY_ADD.
+    2, // OPCODE_SCAN_LEFT.
+    2, // OPCODE_SCAN_RIGHT.
+    2 + CELL_ARGUMENT_SIZE, // OPCODE_ADD_AT.
+    2, // OPCODE_PRINT_AT.
+    2, // OPCODE_SET_ZERO_AT.
+    2, // OPCODE_JEQ_SHORT.
+    2, // OPCODE_JNE_SHORT.
+    3, // OPCODE_CHECK_BOUNDS.
+    2, // OPCODE_BFMEM_LEFT_UNCHECKED.
+    2, // OPCODE_BFMEM_RIGHT_UNCHECKED.
+    4  // OPCODE_PRINT_STRING.
 };
+// The size of the largest opcode, with arguments.
+#define MAX_OPCODE_SIZE 4
 
 // A table mapping from instruction characters to their corresponding opcodes.
 // Index value must not exceed 255.
@@ -499,7 +947,7 @@ static void initializeInstructionOpcodeTable(void) {
     for (; i < 255; ++i) instruction_opcode_table[i] = 0xFF;
     instruction_opcode_table[255] = 0xFF;
 
-    instruction_opcode_table[NULL] = OPCODE_HALT;
+    instruction_opcode_table['\0'] = OPCODE_HALT;
     instruction_opcode_table['+']  = OPCODE_INCREMENT;
     instruction_opcode_table['-']  = OPCODE_DECREMENT;
     instruction_opcode_table['<']  = OPCODE_BFMEM_LEFT;
@@ -516,28 +964,122 @@ static void initializeInstructionOpcodeTable(void) {
 }
 
 // Memory for the compiled bytecode of entered BASICfuck code.
-#define PROGRAM_MEMORY_SIZE 256
 static opcode_t program_memory[PROGRAM_MEMORY_SIZE] = {0};
 
+// Gets and sets the address that the jump instruction at the given location
+// jumps to. Pointers on the host computer don't fit in a jump's 16-bit
+// argument, so there it is stored as an offset into program memory instead.
+#ifdef __CC65__
+#  define GET_JUMP_TARGET(instruction) (*(opcode_t**)((instruction) + 1))
+#  define SET_JUMP_TARGET(instruction, target)                                 \
+    (*(opcode_t**)((instruction) + 1) = (target))
+#else // __CC65__
+#  define GET_JUMP_TARGET(instruction)                                         \
+    (program_memory + ((instruction)[1] | (instruction)[2] << 8))
+#  define SET_JUMP_TARGET(instruction, target)                                 \
+    ((instruction)[1] = (uint8_t)((target) - program_memory),                  \
+     (instruction)[2] = (uint8_t)(((target) - program_memory) >> 8))
+#endif
+
 // Compiler state.
 // Pointer to the current position in the read buffer.
 static const uint8_t* compiler_read_pointer = NULL;
+// Pointer to the end of the current chunk of the source file in the read
+// buffer, or NULL if the whole program is already in it.
+static const uint8_t* compiler_read_pointer_end = NULL;
+// The file the program is read from, or -1 to read it from the edit buffer.
+static int compiler_source_file = -1;
+// Whether reading the source file failed.
+static bool compiler_read_error = false;
 // Pointer to the current position in the write buffer.
 static opcode_t* compiler_write_pointer = NULL;
 // Pointer to the end of the write buffer.
 static opcode_t* compiler_write_pointer_end = NULL;
 
-// Performs the first pass of BASICfuck compilation, converting the text program
-// to opcodes.
-// true if succeeded, false if ran out of memory.
-static bool compileFirstPass(void) {
+// Returns the file name following the command of the given length at the start
+// of the edit buffer, or NULL, after printing an error message, if there isn't
+// one.
+// edit_buffer (global) - the command with the file name.
+static const char* __fastcall__ commandFileName(const uint8_t command_length) {
+    const char* file_name = (const char*)edit_buffer + command_length;
+
+    while (' ' == *file_name) ++file_name;
+    if ('\0' == *file_name) {
+        puts("?MISSING FILE NAME");
+        return NULL;
+    }
+    return file_name;
+}
+
+// Opens the file named after the command at the start of the edit buffer, so
+// the next program compiled is read from it instead. Prints an error message
+// and returns false if it couldn't be opened.
+// edit_buffer (global) - the command with the file name.
+// compiler_source_file (global) - set to the opened file.
+static bool openSourceFile(void) {
+    const char* file_name = commandFileName(1);
+
+    if (NULL == file_name) return false;
+
+    compiler_source_file = open(file_name, O_RDONLY);
+    if (compiler_source_file < 0) {
+        compiler_source_file = -1;
+        puts("?CANNOT OPEN FILE");
+        return false;
+    }
+    return true;
+}
+
+// Closes the file opened by openSourceFile(), if there is one, so programs are
+// read from the edit buffer again.
+// compiler_source_file (global) - the file.
+static void closeSourceFile(void) {
+    if (-1 == compiler_source_file) return;
+    close(compiler_source_file);
+    compiler_source_file = -1;
+}
+
+// Reads the next chunk of the source file into the edit buffer, which is free to
+// reuse once the command that opened the file has been read. Only a chunk is
+// held at a time, so files can be much larger than the edit buffer.
+// Returns the first character of the chunk, or '\0' at the end of the file.
+// compiler_source_file (global) - the file to read.
+// edit_buffer (global) - where the chunk is placed.
+static uint8_t compilerReadChunk(void) {
+    const int count = read(compiler_source_file, edit_buffer, EDIT_BUFFER_SIZE);
+
+    compiler_read_pointer = edit_buffer;
+    if (count <= 0) {
+        if (count < 0) compiler_read_error = true;
+        edit_buffer[0]            = '\0';
+        compiler_read_pointer_end = NULL;
+        return '\0';
+    }
+
+    compiler_read_pointer_end = edit_buffer + count;
+    return edit_buffer[0];
+}
+
+// Returns the character at the read pointer, reading the next chunk of the
+// source file first if the current one is used up.
+#define COMPILER_PEEK()                                                        \
+    (compiler_read_pointer == compiler_read_pointer_end                        \
+     ? compilerReadChunk() : *compiler_read_pointer)
+
+// Converts the text at the read pointer to opcodes at the write pointer, up to,
+// and including, the OPCODE_HALT at the end of the text.
+// Returns an error message on failure, or NULL on success.
+// compiler_read_pointer, compiler_read_pointer_end (global) - the text.
+// compiler_write_pointer, compiler_write_pointer_end (global) - where the
+// opcodes go. Left on the OPCODE_HALT.
+static const char* compileInstructions(void) {
     uint8_t  instruction = 0;
     opcode_t opcode      = 0;
 
     // Used by counted instructions.
-    uint16_t instruction_count = 0;
-    uint8_t  other_instruction = 0;
-    uint8_t  chunk_count       = 0;
+    int16_t  instruction_count = 0;
+    opcode_t other_opcode      = 0;
+    opcode_t opposite_opcode   = 0;
 
     static const void *const jump_table[] = {
         &&lfinish_bytecode_compilation,      // OPCODE_HALT.
@@ -556,13 +1098,8 @@ static bool compileFirstPass(void) {
         &&lcompile_instruction_no_arugments  // OPCODE_EXECUTE.
     };
 
-    // Initialize compiler.
-    compiler_read_pointer = edit_buffer;
-    compiler_write_pointer = program_memory;
-    compiler_write_pointer_end = PROGRAM_MEMORY_SIZE - 1 + program_memory;
-
     while (true) {
-        instruction = *compiler_read_pointer;
+        instruction = COMPILER_PEEK();
         opcode      = instruction_opcode_table[instruction];
 
         // Ignores non-instructions.
@@ -583,7 +1120,7 @@ lfinish_bytecode_compilation: {
         // Takes no arguments.
 lcompile_instruction_no_arugments: {
             if (compiler_write_pointer >= compiler_write_pointer_end) {
-                return false;
+                return "?OUT OF MEMORY";
             }
 
             *(compiler_write_pointer++) = opcode;
@@ -596,7 +1133,7 @@ lcompile_instruction_no_arugments: {
         // which will be handled by the second pass.
 lcompile_jump_instruction: {
             if (compiler_write_pointer + 2 >= compiler_write_pointer_end) {
-                return false;
+                return "?OUT OF MEMORY";
             }
 
             *(compiler_write_pointer++) = opcode;
@@ -608,54 +1145,99 @@ lcompile_jump_instruction: {
         }
 
         // Takes an 8-bit count of how many times to preform the operation.
+        // Consecutive increments and decrements, like +-+, are counted
+        // together, cancelling out. Moves aren't, since <> on the first cell
+        // must still stop the program, and () on $0000 must still end on $0001.
 lcompile_counted_instruction: {
             instruction_count = 0;
+            // Moves are their own opposite, so they never count down.
+            opposite_opcode = OPCODE_INCREMENT == opcode ? OPCODE_DECREMENT
+                              : OPCODE_DECREMENT == opcode ? OPCODE_INCREMENT
+                              : opcode;
 
-            // Count number of consecutive instructions.
+            // Count the net number of consecutive instructions.
             while (true) {
-                other_instruction = *compiler_read_pointer;
+                other_opcode = instruction_opcode_table[COMPILER_PEEK()];
 
-                if (other_instruction != instruction) {
+                if (other_opcode == opcode) {
+                    ++instruction_count;
+                } else if (other_opcode == opposite_opcode) {
+                    --instruction_count;
+                } else {
                     break;
                 }
 
-                ++instruction_count;
                 ++compiler_read_pointer;
+
+                // Each instruction opcode can only take an 8-bit value, so full
+                // 8-bit chunks are written out as they are counted, which also
+                // keeps runs from files, which can be any length, from
+                // overflowing the count.
+                if (255 == instruction_count || -255 == instruction_count) {
+                    if (compiler_write_pointer + 1
+                            >= compiler_write_pointer_end) {
+                        return "?OUT OF MEMORY";
+                    }
+
+                    *(compiler_write_pointer++) = instruction_count < 0
+                                                  ? opposite_opcode : opcode;
+                    *(compiler_write_pointer++) = 255;
+
+                    instruction_count = 0;
+                }
+            }
+
+            // More of the opposite instruction means doing that one instead.
+            if (instruction_count < 0) {
+                opcode            = opposite_opcode;
+                instruction_count = -instruction_count;
             }
 
-            // Each instruction opcode can only take an 8-bit value, so this chops up
-            // the full count into separate 8-bit chunks.
-            while (instruction_count > 0) {
+            if (instruction_count > 0) {
                 if (compiler_write_pointer + 1 >= compiler_write_pointer_end) {
-                    return false;
+                    return "?OUT OF MEMORY";
                 }
 
-                chunk_count = instruction_count > 255 ? 255
-                              : (uint8_t)instruction_count;
-
                 *(compiler_write_pointer++) = opcode;
-                *(compiler_write_pointer++) = chunk_count;
-
-                instruction_count -= (uint16_t)chunk_count;
+                *(compiler_write_pointer++) = (uint8_t)instruction_count;
             }
 
             continue;
         }
     }
 
-    return true;
+    return compiler_read_error ? "?READ ERROR" : NULL;
+}
+
+// Performs the first pass of BASICfuck compilation, converting the text program,
+// from the edit buffer or the source file, to opcodes.
+// Returns an error message on failure, or NULL on success.
+static const char* compileFirstPass(void) {
+    // Initialize compiler. With a source file, the first peek reads the first
+    // chunk.
+    compiler_read_pointer = edit_buffer;
+    compiler_read_pointer_end = -1 == compiler_source_file ? NULL : edit_buffer;
+    compiler_read_error = false;
+    compiler_write_pointer = program_memory;
+    compiler_write_pointer_end = PROGRAM_MEMORY_SIZE - 1 + program_memory;
+
+    return compileInstructions();
 }
 
+// The maximum depth that loops can be nested to.
+#define MAX_LOOP_DEPTH 64
+// Stack of the currently open loops. Used by the second pass to match JEQ
+// instructions with their JNE instructions, and afterwards by the native code
+// generator to patch the jumps it emits.
+static opcode_t* compiler_loop_stack[MAX_LOOP_DEPTH] = {0};
+
 // Performs the second pass of BASICfuck compilation, calculating the addresses
 // for jump instructions.
-// Returns true if succeeded, false if there is an unterminated loop.
-static bool compileSecondPass(void) {
-    opcode_t* write_start_pointer = compiler_write_pointer;
-    opcode_t  opcode              = 0;
-    uint16_t  loop_depth          = 0;
-
-    opcode_t* seek_pointer  = NULL;
-    opcode_t  seeked_opcode = 0;
+// Returns NULL if succeeded, else the error message to display.
+static const char* compileSecondPass(void) {
+    opcode_t  opcode       = 0;
+    uint8_t   loop_depth   = 0;
+    opcode_t* loop_pointer = NULL;
 
     // Initialize compiler.
     compiler_write_pointer = program_memory;
@@ -663,139 +1245,1562 @@ static bool compileSecondPass(void) {
     while (OPCODE_HALT != (opcode = *compiler_write_pointer)) {
         switch (opcode) {
         case OPCODE_JEQ:
-            seek_pointer = compiler_write_pointer + opcode_size_table[OPCODE_JEQ];
-            loop_depth   = 1;
-
-            // Finds and links with accomanying JNE instruction.
-            while (OPCODE_HALT != (seeked_opcode = *seek_pointer)) {
-                switch (seeked_opcode) {
-                case OPCODE_JEQ: {
-                    ++loop_depth;
-                    break;
-                }
-                case OPCODE_JNE: {
-                    --loop_depth;
-                    break;
-                }
-                }
-
-                if (loop_depth == 0) {
-                    // Sets JEQ instruction to jump to accomanying JNE.
-                    *(opcode_t**)(compiler_write_pointer + 1) = seek_pointer;
-                    // And vice-versa.
-                    *(opcode_t**)(seek_pointer + 1) = compiler_write_pointer;
-
-                    break;
-                }
-
-                seek_pointer += opcode_size_table[seeked_opcode];
-            }
-
-            if (loop_depth != 0) return false;
-
+        case OPCODE_JEQ_SHORT: {
+            if (loop_depth >= MAX_LOOP_DEPTH) return "?TOO DEEP";
+            compiler_loop_stack[loop_depth++] = compiler_write_pointer;
             break;
+        }
 
         case OPCODE_JNE:
-            // Address should have been set by some preceeding JEQ instruction.
-            if (0xFFFF == *(uint16_t*)(compiler_write_pointer + 1)) {
-                return false;
+        case OPCODE_JNE_SHORT: {
+            if (0 == loop_depth) return "?UNTERMINATED LOOP";
+            loop_pointer = compiler_loop_stack[--loop_depth];
+
+            // Short jumps only ever come in pairs, and hold the distance to
+            // each other.
+            if (OPCODE_JNE_SHORT == opcode) {
+                loop_pointer[1] =
+                    (uint8_t)(compiler_write_pointer - loop_pointer);
+                compiler_write_pointer[1] =
+                    (uint8_t)(loop_pointer - compiler_write_pointer);
+                break;
             }
 
+            // Sets JEQ instruction to jump to accomanying JNE.
+            SET_JUMP_TARGET(loop_pointer, compiler_write_pointer);
+            // And vice-versa.
+            SET_JUMP_TARGET(compiler_write_pointer, loop_pointer);
+
             break;
         }
+        }
 
         compiler_write_pointer += opcode_size_table[opcode];
     }
 
-    return true;
+    return 0 == loop_depth ? NULL : "?UNTERMINATED LOOP";
 }
 
-typedef uint8_t cell_t;
-
-static cell_t basicfuck_memory[BASICFUCK_MEMORY_SIZE] = {0};
-// Pointer to one after the end of the memory.
-static const cell_t *const basicfuck_memory_end = basicfuck_memory +
-    BASICFUCK_MEMORY_SIZE;
-
-// Interpreter state.
-static const opcode_t* interpreter_program_pointer = NULL;
-static cell_t* interpreter_bfmem_pointer = basicfuck_memory;
-static uint8_t* interpreter_cmem_pointer = NULL;
+// Loop idiom recognition state.
+// The maximum number of cells, besides the current one, that a loop can change
+// and still be recognized.
+#define IDIOM_MAX_CELLS 8
+// The offset of each cell changed by the loop, and how much it is changed by
+// each iteration. The current cell is always first.
+static int8_t  idiom_offsets[IDIOM_MAX_CELLS + 1] = {0};
+static cell_t  idiom_deltas[IDIOM_MAX_CELLS + 1]  = {0};
+static uint8_t idiom_cell_count                   = 0;
+
+// Checks whether the loop at the given linked JEQ instruction only adds to
+// cells at fixed offsets from the current one, ends up back on the current
+// cell, and changes the current cell by exactly 1 each iteration. Loops like
+// that run once per unit of the current cell's value, and so can be replaced
+// with a multiplication. The loop must also not move further than the cells it
+// changes, so that the multiplication stops the program wherever the loop
+// would have left BASICfuck memory.
+// Returns true if so, with idiom_offsets[] and idiom_deltas[] filled in.
+static bool matchLoopIdiom(const opcode_t* loop_pointer) {
+    const opcode_t* loop_end_pointer = GET_JUMP_TARGET(loop_pointer);
+    int16_t         offset           = 0;
+    int16_t         left             = 0;
+    int16_t         right            = 0;
+    cell_t          delta            = 0;
+    uint8_t         i                = 0;
+
+    idiom_offsets[0] = 0;
+    idiom_deltas[0]  = 0;
+    idiom_cell_count = 1;
+
+    loop_pointer += opcode_size_table[OPCODE_JEQ];
+    // Each of the accepted instructions are 2 bytes long.
+    for (; loop_pointer < loop_end_pointer; loop_pointer += 2) {
+        switch (*loop_pointer) {
+        case OPCODE_BFMEM_LEFT: {
+            offset -= loop_pointer[1];
+            if (offset < INT8_MIN) return false;
+            if (offset < left) left = offset;
+            continue;
+        }
+        case OPCODE_BFMEM_RIGHT: {
+            offset += loop_pointer[1];
+            if (offset > INT8_MAX) return false;
+            if (offset > right) right = offset;
+            continue;
+        }
+        case OPCODE_INCREMENT: {
+            delta = loop_pointer[1];
+            break;
+        }
+        case OPCODE_DECREMENT: {
+            delta = -loop_pointer[1];
+            break;
+        }
+        default: {
+            return false;
+        }
+        }
 
-// Global variables for exchaning values with inline assembler.
-static uint8_t interpreter_register_a = 0;
-static uint8_t interpreter_register_x = 0;
-static uint8_t interpreter_register_y = 0;
+        for (i = 0; i < idiom_cell_count; ++i) {
+            if (idiom_offsets[i] == offset) break;
+        }
+        if (i == idiom_cell_count) {
+            if (i > IDIOM_MAX_CELLS) return false;
+            idiom_offsets[i] = (int8_t)offset;
+            idiom_deltas[i]  = 0;
+            ++idiom_cell_count;
+        }
+        idiom_deltas[i] += delta;
+    }
 
-// Runs the execute part of the BASICfuck execute instruction.
-// interpreter_register_a (global) - the value to place in the A register.
-// interpreter_register_x (global) - the value to place in the X register.
-// interpreter_register_y (global) - the value to place in the Y register.
-// interpreter_cmem_pointer (global) - the address to execute as a subroutine.
-static void basicfuckExecute(void) {
-    // Overwrites address of subroutine to call in next assembly block with the
-    // computer memory pointer's value.
-    __asm__ volatile ("lda %v",   interpreter_cmem_pointer);
-    __asm__ volatile ("sta %g+1", ljump_instruction);
-    __asm__ volatile ("lda %v+1", interpreter_cmem_pointer);
-    __asm__ volatile ("sta %g+2", ljump_instruction);
-    // Executes subroutine.
-    __asm__ volatile ("lda %v", interpreter_register_a);
-    __asm__ volatile ("ldx %v", interpreter_register_x);
-    __asm__ volatile ("ldy %v", interpreter_register_y);
-ljump_instruction:
-    __asm__ volatile ("jsr %w", NULL);
-    // Retrieves resuting values.
-    __asm__ volatile ("sta %v", interpreter_register_a);
-    __asm__ volatile ("stx %v", interpreter_register_x);
-    __asm__ volatile ("sty %v", interpreter_register_y);
+    // Cells left unchanged aren't multiplied into, so don't count.
+    for (i = 1; i < idiom_cell_count; ++i) {
+        if (0 == idiom_deltas[i]) continue;
+        if (idiom_offsets[i] == left)  left  = 0;
+        if (idiom_offsets[i] == right) right = 0;
+    }
 
-    return;
-    // If we don't include a jmp instruction, cc65, annoyingly, strips the label
-    // from the resulting assembly.
-    __asm__ volatile ("jmp %g", ljump_instruction);
+    return 0 == offset && 0 == left && 0 == right
+           && (1 == idiom_deltas[0] || (cell_t)-1 == idiom_deltas[0]);
 }
 
-// Runs the interpreter with the given bytecode-compiled BASICfuck program.
-// interpreter_bfmem_pointer (global) - the current BASICfuck memory pointer.
-// interpreter_cmem_pointer (global) - the current computer memory pointer.
-static void interpret(void) {
-    opcode_t opcode   = 0;
-    uint8_t  argument = 0;
-
-    static const void *const jump_table[] = {
-        &&lopcode_halt,        // OPCODE_HALT.
-        &&lopcode_increment,   // OPCODE_INCREMENT.
-        &&lopcode_decrement,   // OPCODE_DECREMENT.
-        &&lopcode_bfmem_left,  // OPCODE_BFMEM_LEFT.
-        &&lopcode_bfmem_right, // OPCODE_BFMEM_RIGHT.
-        &&lopcode_print,       // OPCODE_PRINT.
-        &&lopcode_input,       // OPCODE_INPUT.
-        &&lopcode_jeq,         // OPCODE_JEQ.
-        &&lopcode_jne,         // OPCODE_JNE.
-        &&lopcode_cmem_read,   // OPCODE_CMEM_READ.
-        &&lopcode_cmem_write,  // OPCODE_CMEM_WRITE.
-        &&lopcode_cmem_left,   // OPCODE_CMEM_LEFT.
-        &&lopcode_cmem_right,  // OPCODE_CMEM_RIGHT.
-        &&lopcode_execute      // OPCODE_EXECUTE.
-    };
+// Performs the idiom recognition pass of BASICfuck compilation, replacing
+// clear loops, like [-], with OPCODE_SET_ZERO, move and multiply loops, like
+// [->+<] and [->+++>++<<], with OPCODE_MULTIPLY_ADD followed by
+// OPCODE_SET_ZERO, and scan loops, like [>] and [<<], with OPCODE_SCAN_RIGHT
+// and OPCODE_SCAN_LEFT.
+// Must be run after the second pass, and relinks the jumps if anything was
+// replaced.
+static void compileIdiomPass(void) {
+    const opcode_t* read_pointer     = program_memory;
+    const opcode_t* loop_end_pointer = NULL;
+    opcode_t        opcode           = 0;
+    cell_t          factor           = 0;
+    uint8_t         i                = 0;
+    bool            replaced         = false;
 
-    // Initialize interpreter.
-    interpreter_program_pointer = program_memory;
+    compiler_write_pointer = program_memory;
 
-    while (true) {
-        if (0 != kbhit() && KEYBOARD_STOP == cgetc()) {
-            puts("?ABORT");
-            break;
+    while (OPCODE_HALT != (opcode = *read_pointer)) {
+        if (OPCODE_JEQ != opcode) goto lcopy_instruction;
+        loop_end_pointer = GET_JUMP_TARGET(read_pointer);
+
+        // Scan loops consist of a single move.
+        if (loop_end_pointer == read_pointer + 5
+                && (OPCODE_BFMEM_LEFT == read_pointer[3]
+                    || OPCODE_BFMEM_RIGHT == read_pointer[3])) {
+            *(compiler_write_pointer++) =
+                OPCODE_BFMEM_LEFT == read_pointer[3] ? OPCODE_SCAN_LEFT
+                : OPCODE_SCAN_RIGHT;
+            *(compiler_write_pointer++) = read_pointer[4];
+
+            read_pointer = loop_end_pointer + opcode_size_table[OPCODE_JNE];
+            replaced     = true;
+            continue;
         }
 
-        opcode   = *interpreter_program_pointer;
-        argument = interpreter_program_pointer[1];
-        assert(opcode < ARRAY_SIZE(jump_table) && "unreachable");
-        goto *jump_table[opcode];
+        if (matchLoopIdiom(read_pointer)) {
+            read_pointer = loop_end_pointer + opcode_size_table[OPCODE_JNE];
+            replaced     = true;
+
+            // The replacement is always smaller than the loop, so it can be
+            // written in-place.
+            for (i = 1; i < idiom_cell_count; ++i) {
+                factor = idiom_deltas[i];
+                if (0 == factor) continue;
+                // Loops counting up run 2^CELL_WIDTH - n times instead of n,
+                // which negates the result.
+                if (1 == idiom_deltas[0]) factor = -factor;
+
+                *(compiler_write_pointer++) = OPCODE_MULTIPLY_ADD;
+                *(compiler_write_pointer++) = (uint8_t)idiom_offsets[i];
+                WRITE_CELL_ARGUMENT(factor);
+            }
+            *(compiler_write_pointer++) = OPCODE_SET_ZERO;
 
-lopcode_halt: {
-            break;
+            continue;
+        }
+
+lcopy_instruction:
+        for (i = opcode_size_table[opcode]; i > 0; --i) {
+            *(compiler_write_pointer++) = *(read_pointer++);
+        }
+    }
+    *compiler_write_pointer = OPCODE_HALT;
+
+    if (replaced) {
+        compileSecondPass();
+    }
+}
+
+// Offset folding state.
+// The maximum number of instructions that can be folded into a single run.
+#define OFFSET_MAX_RUN_LENGTH 16
+// The opcode of each instruction in the run (OPCODE_INCREMENT for any add,)
+// the offset of the cell it works on from the start of the run, and, for adds,
+// the amount to add. Adds of 0 are left out when the run is written.
+static opcode_t offset_run_opcodes[OFFSET_MAX_RUN_LENGTH] = {0};
+static int8_t   offset_run_offsets[OFFSET_MAX_RUN_LENGTH] = {0};
+static cell_t   offset_run_amounts[OFFSET_MAX_RUN_LENGTH] = {0};
+static uint8_t  offset_run_length                       = 0;
+// The furthest the run moves the cell pointer to the left and the right of
+// where it started.
+static int16_t  offset_run_left                         = 0;
+static int16_t  offset_run_right                        = 0;
+
+// Adds an instruction to the current run. Adds to a cell are combined, and adds
+// to a cell that is then set to 0 are dropped, so long as nothing is printed in
+// between, so that the instructions before a print stay as they were checked by
+// offsetRunCovers().
+static void recordOffsetRun(
+    const opcode_t opcode,
+    const int8_t   offset,
+    const cell_t   amount
+) {
+    uint8_t i = offset_run_length;
+
+    while (i > 0) {
+        --i;
+        if (OPCODE_PRINT == offset_run_opcodes[i]) break;
+        if (offset_run_offsets[i] != offset) continue;
+
+        if (OPCODE_INCREMENT == opcode) {
+            if (OPCODE_INCREMENT != offset_run_opcodes[i]) break;
+            offset_run_amounts[i] += amount;
+            return;
+        }
+        if (OPCODE_SET_ZERO == opcode) {
+            // Already set to 0.
+            if (OPCODE_SET_ZERO == offset_run_opcodes[i]) return;
+            offset_run_amounts[i] = 0;
+            continue;
+        }
+        break;
+    }
+
+    offset_run_opcodes[offset_run_length] = opcode;
+    offset_run_offsets[offset_run_length] = offset;
+    offset_run_amounts[offset_run_length] = amount;
+    ++offset_run_length;
+}
+
+// Returns whether the instructions of the run, and a move by the given amount,
+// together work on cells as far to the left and the right as the run moves the
+// cell pointer to. Only then does the folded run still stop the program when
+// the original would leave BASICfuck memory.
+static bool offsetRunCovers(const int16_t move) {
+    int16_t left  = move < 0 ? move : 0;
+    int16_t right = move > 0 ? move : 0;
+    uint8_t i     = 0;
+
+    for (i = 0; i < offset_run_length; ++i) {
+        // Adds of 0 aren't written.
+        if (OPCODE_INCREMENT == offset_run_opcodes[i]
+                && 0 == offset_run_amounts[i]) {
+            continue;
+        }
+        if (offset_run_offsets[i] < left)  left  = offset_run_offsets[i];
+        if (offset_run_offsets[i] > right) right = offset_run_offsets[i];
+    }
+
+    return left <= offset_run_left && right >= offset_run_right;
+}
+
+// Returns the size of the given instruction of the run when written relative to
+// the given cell, or 0xFF if it can't be.
+static uint8_t offsetRunInstructionSize(const uint8_t i, const int16_t origin) {
+    const int16_t offset = offset_run_offsets[i] - origin;
+
+    if (offset < INT8_MIN || offset > INT8_MAX) return 0xFF;
+    switch (offset_run_opcodes[i]) {
+    case OPCODE_INCREMENT:
+        if (0 == offset_run_amounts[i]) return 0;
+        return opcode_size_table[0 == offset
+                                 && IS_COUNTED_AMOUNT(offset_run_amounts[i])
+                                 ? OPCODE_INCREMENT : OPCODE_ADD_AT];
+    case OPCODE_PRINT:
+        return opcode_size_table[0 == offset ? OPCODE_PRINT : OPCODE_PRINT_AT];
+    default:
+        return opcode_size_table[0 == offset ? OPCODE_SET_ZERO
+                                 : OPCODE_SET_ZERO_AT];
+    }
+}
+
+// Writes an instruction of the run relative to the given cell.
+static void writeOffsetRunInstruction(const uint8_t i, const int16_t origin) {
+    const int8_t offset = (int8_t)(offset_run_offsets[i] - origin);
+    const cell_t amount = offset_run_amounts[i];
+
+    switch (offset_run_opcodes[i]) {
+    case OPCODE_INCREMENT: {
+        if (0 == amount) return;
+        if (0 != offset || !IS_COUNTED_AMOUNT(amount)) {
+            *(compiler_write_pointer++) = OPCODE_ADD_AT;
+            *(compiler_write_pointer++) = (uint8_t)offset;
+            WRITE_CELL_ARGUMENT(amount);
+        } else if (amount > (cell_t)-1 / 2 + 1) {
+            *(compiler_write_pointer++) = OPCODE_DECREMENT;
+            *(compiler_write_pointer++) = -amount;
+        } else {
+            *(compiler_write_pointer++) = OPCODE_INCREMENT;
+            *(compiler_write_pointer++) = amount;
+        }
+        return;
+    }
+    case OPCODE_PRINT: {
+        if (0 != offset) {
+            *(compiler_write_pointer++) = OPCODE_PRINT_AT;
+            *(compiler_write_pointer++) = (uint8_t)offset;
+        } else {
+            *(compiler_write_pointer++) = OPCODE_PRINT;
+        }
+        return;
+    }
+    default: {
+        if (0 != offset) {
+            *(compiler_write_pointer++) = OPCODE_SET_ZERO_AT;
+            *(compiler_write_pointer++) = (uint8_t)offset;
+        } else {
+            *(compiler_write_pointer++) = OPCODE_SET_ZERO;
+        }
+        return;
+    }
+    }
+}
+
+// Writes the current run, which was read from the given span of program memory
+// and moves the cell pointer by the given amount overall, and then empties it.
+// The move is placed wherever in the run leaves the most instructions on the
+// current cell, since those have shorter forms. If that ends up larger than the
+// original code, or wouldn't stop the program where the original code would,
+// the original code is copied instead.
+// Returns true if the run was folded.
+static bool writeOffsetRun(
+    const opcode_t* run_pointer,
+    const opcode_t* run_end_pointer,
+    const int16_t   move
+) {
+    uint16_t best_size  = UINT16_MAX;
+    uint16_t size       = 0;
+    uint8_t  best_split = 0;
+    uint8_t  split      = 0;
+    uint8_t  i          = 0;
+    uint16_t distance   = move < 0 ? -move : move;
+    bool     covered    = offsetRunCovers(move);
+
+    for (split = 0; split <= offset_run_length; ++split) {
+        size = 2 * ((distance + 254) / 255);
+        for (i = 0; i < offset_run_length; ++i) {
+            size += offsetRunInstructionSize(i, i < split ? 0 : move);
+        }
+        if (size < best_size) {
+            best_size  = size;
+            best_split = split;
+        }
+    }
+
+    offset_run_left  = 0;
+    offset_run_right = 0;
+    if (best_size > (uint16_t)(run_end_pointer - run_pointer) || !covered) {
+        while (run_pointer < run_end_pointer) {
+            *(compiler_write_pointer++) = *(run_pointer++);
+        }
+        offset_run_length = 0;
+        return false;
+    }
+
+    for (i = 0; i < best_split; ++i) writeOffsetRunInstruction(i, 0);
+    while (distance > 0) {
+        *(compiler_write_pointer++) =
+            move < 0 ? OPCODE_BFMEM_LEFT : OPCODE_BFMEM_RIGHT;
+        *(compiler_write_pointer++) = distance > 255 ? 255 : (uint8_t)distance;
+        distance -= distance > 255 ? 255 : distance;
+    }
+    for (; i < offset_run_length; ++i) writeOffsetRunInstruction(i, move);
+
+    offset_run_length = 0;
+    return true;
+}
+
+// Performs the offset folding pass of BASICfuck compilation, replacing runs of
+// straight-line code, like >+>++<<-, with instructions that work on cells at an
+// offset from the current one, like OPCODE_ADD_AT, and a single move of the
+// cell pointer.
+// Must be run after the idiom pass, and relinks the jumps if anything was
+// folded.
+static void compileOffsetPass(void) {
+    const opcode_t* read_pointer = program_memory;
+    const opcode_t* run_pointer  = program_memory;
+    opcode_t        opcode       = 0;
+    int16_t         offset       = 0;
+    uint8_t         i            = 0;
+    bool            folded       = false;
+
+    compiler_write_pointer = program_memory;
+    offset_run_length      = 0;
+    offset_run_left        = 0;
+    offset_run_right       = 0;
+
+    while (true) {
+        opcode = *read_pointer;
+
+        switch (opcode) {
+        case OPCODE_BFMEM_LEFT:
+        case OPCODE_BFMEM_RIGHT: {
+            // Starts a new run before the offset could overflow, since runs of
+            // moves from files can be any length.
+            if (offset < INT16_MIN + UINT8_MAX
+                    || offset > INT16_MAX - UINT8_MAX) {
+                folded     |= writeOffsetRun(run_pointer, read_pointer, offset);
+                run_pointer = read_pointer;
+                offset      = 0;
+            }
+
+            if (OPCODE_BFMEM_LEFT == opcode) {
+                offset -= read_pointer[1];
+            } else {
+                offset += read_pointer[1];
+            }
+            if (offset < offset_run_left)  offset_run_left  = offset;
+            if (offset > offset_run_right) offset_run_right = offset;
+            break;
+        }
+        case OPCODE_INCREMENT:
+        case OPCODE_DECREMENT:
+        case OPCODE_PRINT:
+        case OPCODE_SET_ZERO: {
+            // Starts a new run if this one can't take any more, or, before a
+            // print, if the run so far and the print, which checks its own
+            // cell, wouldn't stop the program first where the original would
+            // leave BASICfuck memory.
+            if (offset < INT8_MIN || offset > INT8_MAX
+                    || OFFSET_MAX_RUN_LENGTH == offset_run_length
+                    || (OPCODE_PRINT == opcode && !offsetRunCovers(offset))) {
+                folded     |= writeOffsetRun(run_pointer, read_pointer, offset);
+                run_pointer = read_pointer;
+                offset      = 0;
+            }
+
+            recordOffsetRun(
+                OPCODE_DECREMENT == opcode ? OPCODE_INCREMENT : opcode,
+                (int8_t)offset,
+                OPCODE_DECREMENT == opcode ? -read_pointer[1] : read_pointer[1]
+            );
+            break;
+        }
+        default: {
+            folded |= writeOffsetRun(run_pointer, read_pointer, offset);
+            offset  = 0;
+
+            for (i = opcode_size_table[opcode]; i > 0; --i) {
+                *(compiler_write_pointer++) = *(read_pointer++);
+            }
+            run_pointer = read_pointer;
+
+            if (OPCODE_HALT == opcode) {
+                // Points to the end of the program, like the other passes.
+                --compiler_write_pointer;
+                if (folded) compileSecondPass();
+                return;
+            }
+            continue;
+        }
+        }
+
+        read_pointer += opcode_size_table[opcode];
+    }
+}
+
+// The unchecked moves from the bounds pass would walk off the edge of the
+// window, so banked tape goes without.
+#ifndef BANKED_TAPE
+// Bounds analysis state, for each currently open loop.
+// Where the cell pointer is relative to the start of the loop, and the furthest
+// it gets to the left and the right. Only inner loops that end up back where
+// they started are followed, since they leave the pointer where it was.
+static int16_t bounds_offsets[MAX_LOOP_DEPTH]   = {0};
+static int16_t bounds_lefts[MAX_LOOP_DEPTH]     = {0};
+static int16_t bounds_rights[MAX_LOOP_DEPTH]    = {0};
+// Whether the cell pointer is still where the above says it is, which stops
+// being the case after a scan or a loop that doesn't end up back where it
+// started.
+static bool    bounds_known[MAX_LOOP_DEPTH]     = {0};
+// Whether the loop's moves have been made unchecked.
+static bool    bounds_unchecked[MAX_LOOP_DEPTH] = {0};
+
+// Performs the bounds checking pass of BASICfuck compilation. Loops that always
+// end up back where they started, and move no more than 255 cells in either
+// direction, are given an OPCODE_CHECK_BOUNDS beforehand, so that their own
+// moves can use OPCODE_BFMEM_LEFT_UNCHECKED and OPCODE_BFMEM_RIGHT_UNCHECKED.
+// Leaves the program as-is if the checks don't fit in program memory.
+// Must be run after the offset pass, and relinks the jumps if anything was
+// checked.
+static void compileBoundsPass(void) {
+    opcode_t* read_pointer = program_memory;
+    opcode_t* loop_pointer = NULL;
+    opcode_t  opcode       = 0;
+    uint8_t   size         = 0;
+    uint8_t   loop_depth   = 0;
+    uint8_t   i            = 0;
+    uint16_t  growth       = 0;
+    bool      has_room     = false;
+
+    // Finds the loops that can be checked, marking them by replacing their
+    // JEQ instructions with the checks, which are the same size.
+    while (OPCODE_HALT != (opcode = *read_pointer)) {
+        switch (opcode) {
+        case OPCODE_JEQ: {
+            compiler_loop_stack[loop_depth] = read_pointer;
+            bounds_offsets[loop_depth] = 0;
+            bounds_lefts[loop_depth]   = 0;
+            bounds_rights[loop_depth]  = 0;
+            bounds_known[loop_depth]   = true;
+            ++loop_depth;
+            break;
+        }
+        case OPCODE_JNE: {
+            --loop_depth;
+            if (bounds_known[loop_depth] && 0 == bounds_offsets[loop_depth]) {
+                if (0 != bounds_lefts[loop_depth]
+                        || 0 != bounds_rights[loop_depth]) {
+                    loop_pointer    = compiler_loop_stack[loop_depth];
+                    loop_pointer[0] = OPCODE_CHECK_BOUNDS;
+                    loop_pointer[1] = (uint8_t)-bounds_lefts[loop_depth];
+                    loop_pointer[2] = (uint8_t)bounds_rights[loop_depth];
+                    growth         += opcode_size_table[OPCODE_JEQ];
+                }
+            } else if (0 != loop_depth) {
+                bounds_known[loop_depth - 1] = false;
+            }
+            break;
+        }
+        case OPCODE_BFMEM_LEFT:
+        case OPCODE_BFMEM_RIGHT: {
+            if (0 == loop_depth) break;
+            i = loop_depth - 1;
+            bounds_offsets[i] += OPCODE_BFMEM_LEFT == opcode ? -read_pointer[1]
+                                 : read_pointer[1];
+            if (bounds_offsets[i] < bounds_lefts[i]) {
+                bounds_lefts[i] = bounds_offsets[i];
+            }
+            if (bounds_offsets[i] > bounds_rights[i]) {
+                bounds_rights[i] = bounds_offsets[i];
+            }
+            // Too far to check for.
+            if (bounds_lefts[i] < -UINT8_MAX || bounds_rights[i] > UINT8_MAX) {
+                bounds_known[i] = false;
+            }
+            break;
+        }
+        case OPCODE_SCAN_LEFT:
+        case OPCODE_SCAN_RIGHT: {
+            if (0 != loop_depth) bounds_known[loop_depth - 1] = false;
+            break;
+        }
+        }
+
+        read_pointer += opcode_size_table[opcode];
+    }
+    if (0 == growth) return;
+
+    // Moves the program up to make room for the checks, which are then
+    // inserted while moving it back down.
+    has_room = compiler_write_pointer - program_memory + 1 + growth
+               <= PROGRAM_MEMORY_SIZE;
+    if (has_room) {
+        memmove(program_memory + growth, program_memory,
+                compiler_write_pointer - program_memory + 1);
+        read_pointer = program_memory + growth;
+    } else {
+        read_pointer = program_memory;
+    }
+    compiler_write_pointer = program_memory;
+
+    while (true) {
+        opcode = *read_pointer;
+        // Taken before the instruction is overwritten.
+        size   = opcode_size_table[opcode];
+
+        switch (opcode) {
+        case OPCODE_CHECK_BOUNDS: {
+            if (has_room) {
+                for (i = 0; i < size; ++i) {
+                    *(compiler_write_pointer++) = read_pointer[i];
+                }
+            }
+            // Jump arguments are left for relinking to fill in.
+            opcode = OPCODE_JEQ;
+            bounds_unchecked[loop_depth++] = has_room;
+            break;
+        }
+        case OPCODE_JEQ: {
+            bounds_unchecked[loop_depth++] = false;
+            break;
+        }
+        case OPCODE_JNE: {
+            --loop_depth;
+            break;
+        }
+        case OPCODE_BFMEM_LEFT:
+        case OPCODE_BFMEM_RIGHT: {
+            if (0 != loop_depth && bounds_unchecked[loop_depth - 1]) {
+                opcode = OPCODE_BFMEM_LEFT == opcode
+                         ? OPCODE_BFMEM_LEFT_UNCHECKED
+                         : OPCODE_BFMEM_RIGHT_UNCHECKED;
+            }
+            break;
+        }
+        }
+
+        *compiler_write_pointer = opcode;
+        for (i = 1; i < size; ++i) {
+            compiler_write_pointer[i] = read_pointer[i];
+        }
+        if (OPCODE_HALT == opcode) break;
+        compiler_write_pointer += size;
+        read_pointer           += size;
+    }
+
+    compileSecondPass();
+}
+#endif // BANKED_TAPE
+
+// Performs the jump shortening pass of BASICfuck compilation, replacing the
+// jumps of loops spanning no more than INT8_MAX bytes with OPCODE_JEQ_SHORT and
+// OPCODE_JNE_SHORT, which are a byte smaller and quicker to follow. Code only
+// shrinks in this pass, so a loop that is short enough before it still is after.
+// Must be run last, after the bounds pass, and relinks the jumps if anything
+// was shortened.
+static void compileJumpPass(void) {
+    const opcode_t* read_pointer = program_memory;
+    opcode_t        opcode       = 0;
+    uint8_t         size         = 0;
+    uint8_t         loop_depth   = 0;
+    uint8_t         i            = 0;
+    bool            shortened    = false;
+
+    compiler_write_pointer = program_memory;
+
+    while (OPCODE_HALT != (opcode = *read_pointer)) {
+        // Taken before the instruction is overwritten.
+        size = opcode_size_table[opcode];
+
+        switch (opcode) {
+        case OPCODE_JEQ: {
+            if (GET_JUMP_TARGET(read_pointer) - read_pointer <= INT8_MAX) {
+                opcode    = OPCODE_JEQ_SHORT;
+                shortened = true;
+            }
+            compiler_loop_stack[loop_depth++] = compiler_write_pointer;
+            break;
+        }
+        case OPCODE_JNE: {
+            // The JEQ already written for the loop says whether it is short.
+            if (OPCODE_JEQ_SHORT == *compiler_loop_stack[--loop_depth]) {
+                opcode = OPCODE_JNE_SHORT;
+            }
+            break;
+        }
+        }
+
+        // Jump arguments are left for relinking to fill in.
+        *compiler_write_pointer = opcode;
+        for (i = 1; i < opcode_size_table[opcode]; ++i) {
+            compiler_write_pointer[i] = read_pointer[i];
+        }
+        compiler_write_pointer += opcode_size_table[opcode];
+        read_pointer           += size;
+    }
+    *compiler_write_pointer = OPCODE_HALT;
+
+    if (shortened) compileSecondPass();
+}
+
+// Prefix evaluation state.
+// Whether BASICfuck memory is all 0, with the cell pointer at the start, like
+// when the REPL starts, which makes the start of the next program run the same
+// way every time.
+static bool prefix_memory_zero = true;
+// The most cells, from the start of BASICfuck memory, that can be used while
+// running the start of the program, and the most characters it can print.
+#define PREFIX_MAX_CELLS  32
+#define PREFIX_MAX_OUTPUT 128
+#if BASICFUCK_MEMORY_SIZE < PREFIX_MAX_CELLS
+#  define PREFIX_CELL_COUNT BASICFUCK_MEMORY_SIZE
+#else
+#  define PREFIX_CELL_COUNT PREFIX_MAX_CELLS
+#endif
+// The most instructions to run, so programs that never stop still start.
+#define PREFIX_MAX_STEPS  2048
+// The cells, and what was printed, as of the instruction being run, and the
+// cells as of the last instruction outside of a loop.
+static cell_t  prefix_cells[PREFIX_CELL_COUNT]       = {0};
+static cell_t  prefix_saved_cells[PREFIX_CELL_COUNT] = {0};
+static uint8_t prefix_output[PREFIX_MAX_OUTPUT]      = {0};
+
+// Performs the prefix evaluation pass of BASICfuck compilation. When BASICfuck
+// memory is all 0, what the start of the program does is already known, so it
+// is run here, and replaced with instructions that set the cells it changed and
+// print what it printed with an OPCODE_PRINT_STRING. Loops that build up
+// values, like ++++++++[>++++++++<-], are then never run, and comments, like
+// [this is a comment], which are loops at a cell that is 0, are dropped.
+// Running stops at input, at computer memory, after PREFIX_MAX_STEPS
+// instructions, or on leaving the first PREFIX_MAX_CELLS cells. The program
+// then carries on from before the loop that it stopped in, if any.
+// Leaves the program as-is if it no longer fits in program memory.
+// Must be run last, after the jump pass, right before running the program, and
+// relinks the jumps if anything was run.
+// prefix_memory_zero (global) - whether to run anything.
+static void compilePrefixPass(void) {
+    const opcode_t* read_pointer       = program_memory;
+    const opcode_t* resume_pointer     = program_memory;
+    opcode_t*       string_pointer     = NULL;
+    opcode_t        opcode             = 0;
+    uint8_t         argument           = 0;
+    int16_t         target             = 0;
+    uint8_t         cell               = 0;
+    uint8_t         resume_cell        = 0;
+    uint8_t         output_size        = 0;
+    uint8_t         resume_output_size = 0;
+    uint8_t         loop_depth         = 0;
+    uint16_t        steps              = PREFIX_MAX_STEPS;
+    uint16_t        setup_size         = 0;
+    uint16_t        rest_size          = 0;
+    uint8_t         i                  = 0;
+
+    if (!prefix_memory_zero) return;
+    memset(prefix_cells, 0, sizeof(prefix_cells));
+
+    for (; 0 != steps; --steps) {
+        opcode   = *read_pointer;
+        argument = read_pointer[1];
+
+        // The program can only carry on from outside of loops, so this is
+        // where it does if running stops before the next one.
+        if (0 == loop_depth) {
+            resume_pointer     = read_pointer;
+            resume_cell        = cell;
+            resume_output_size = output_size;
+            memcpy(prefix_saved_cells, prefix_cells, sizeof(prefix_cells));
+            if (OPCODE_HALT == opcode) break;
+        }
+
+        switch (opcode) {
+        case OPCODE_INCREMENT: {
+            prefix_cells[cell] += argument;
+            break;
+        }
+        case OPCODE_DECREMENT: {
+            prefix_cells[cell] -= argument;
+            break;
+        }
+        case OPCODE_BFMEM_LEFT:
+        case OPCODE_BFMEM_LEFT_UNCHECKED: {
+            if (argument > cell) goto lstop;
+            cell -= argument;
+            break;
+        }
+        case OPCODE_BFMEM_RIGHT:
+        case OPCODE_BFMEM_RIGHT_UNCHECKED: {
+            if (cell + argument >= PREFIX_CELL_COUNT) goto lstop;
+            cell += argument;
+            break;
+        }
+        case OPCODE_SET_ZERO: {
+            prefix_cells[cell] = 0;
+            break;
+        }
+        case OPCODE_PRINT:
+        case OPCODE_PRINT_AT: {
+            target = OPCODE_PRINT == opcode ? cell : cell + (int8_t)argument;
+            if (target < 0 || target >= PREFIX_CELL_COUNT
+                    || PREFIX_MAX_OUTPUT == output_size) {
+                goto lstop;
+            }
+            prefix_output[output_size++] = (uint8_t)prefix_cells[target];
+            break;
+        }
+        case OPCODE_MULTIPLY_ADD:
+        case OPCODE_ADD_AT:
+        case OPCODE_SET_ZERO_AT: {
+            target = cell + (int8_t)argument;
+            if (target < 0 || target >= PREFIX_CELL_COUNT) goto lstop;
+            if (OPCODE_MULTIPLY_ADD == opcode) {
+                prefix_cells[target] +=
+                    prefix_cells[cell] * GET_CELL_ARGUMENT(read_pointer + 2);
+            } else if (OPCODE_ADD_AT == opcode) {
+                prefix_cells[target] += GET_CELL_ARGUMENT(read_pointer + 2);
+            } else {
+                prefix_cells[target] = 0;
+            }
+            break;
+        }
+        case OPCODE_SCAN_LEFT: {
+            while (0 != prefix_cells[cell]) {
+                if (argument > cell) goto lstop;
+                cell -= argument;
+            }
+            break;
+        }
+        case OPCODE_SCAN_RIGHT: {
+            while (0 != prefix_cells[cell]) {
+                if (cell + argument >= PREFIX_CELL_COUNT) goto lstop;
+                cell += argument;
+            }
+            break;
+        }
+        // Both jumps land on the other instruction of the loop, which is then
+        // moved past, like in the interpreter.
+        case OPCODE_JEQ:
+        case OPCODE_JEQ_SHORT: {
+            if (0 != prefix_cells[cell]) {
+                ++loop_depth;
+                break;
+            }
+            read_pointer = OPCODE_JEQ == opcode ? GET_JUMP_TARGET(read_pointer)
+                           : read_pointer + (int8_t)argument;
+            break;
+        }
+        case OPCODE_JNE:
+        case OPCODE_JNE_SHORT: {
+            if (0 == prefix_cells[cell]) {
+                --loop_depth;
+                break;
+            }
+            read_pointer = OPCODE_JNE == opcode ? GET_JUMP_TARGET(read_pointer)
+                           : read_pointer + (int8_t)argument;
+            break;
+        }
+        case OPCODE_CHECK_BOUNDS: {
+            // Left for the program to stop at.
+            if (0 != prefix_cells[cell]
+                    && (cell < argument
+                        || cell + read_pointer[2] >= BASICFUCK_MEMORY_SIZE)) {
+                goto lstop;
+            }
+            break;
+        }
+        // Input, computer memory, and the execute instruction.
+        default: {
+            goto lstop;
+        }
+        }
+
+        read_pointer += opcode_size_table[opcode];
+    }
+
+lstop:
+    if (program_memory == resume_pointer) return;
+    memcpy(prefix_cells, prefix_saved_cells, sizeof(prefix_cells));
+    cell        = resume_cell;
+    output_size = resume_output_size;
+
+    setup_size = 0 != cell ? opcode_size_table[OPCODE_BFMEM_RIGHT] : 0;
+    if (0 != output_size) setup_size += opcode_size_table[OPCODE_PRINT_STRING];
+    for (i = 0; i < PREFIX_CELL_COUNT; ++i) {
+        if (0 != prefix_cells[i]) setup_size += opcode_size_table[OPCODE_ADD_AT];
+    }
+    // The rest of the program, including the OPCODE_HALT.
+    rest_size = compiler_write_pointer - resume_pointer + 1;
+    if ((uint16_t)(setup_size + output_size) > PROGRAM_MEMORY_SIZE
+            || rest_size > PROGRAM_MEMORY_SIZE - setup_size - output_size) {
+        return;
+    }
+
+    memmove(program_memory + setup_size, resume_pointer, rest_size);
+    compiler_write_pointer = program_memory;
+
+    if (0 != output_size) {
+        string_pointer = program_memory + setup_size + rest_size;
+        memcpy(string_pointer, prefix_output, output_size);
+        *compiler_write_pointer = OPCODE_PRINT_STRING;
+        SET_JUMP_TARGET(compiler_write_pointer, string_pointer);
+        compiler_write_pointer[3] = output_size;
+        compiler_write_pointer   += opcode_size_table[OPCODE_PRINT_STRING];
+    }
+    // The cell pointer is still at the start.
+    for (i = 0; i < PREFIX_CELL_COUNT; ++i) {
+        if (0 == prefix_cells[i]) continue;
+        *(compiler_write_pointer++) = OPCODE_ADD_AT;
+        *(compiler_write_pointer++) = i;
+        WRITE_CELL_ARGUMENT(prefix_cells[i]);
+    }
+    if (0 != cell) {
+        *(compiler_write_pointer++) = OPCODE_BFMEM_RIGHT;
+        *(compiler_write_pointer++) = cell;
+    }
+
+    compileSecondPass();
+}
+
+#ifdef BANKED_TAPE
+// The cells of the tape in main memory. See Banked Tape.
+static cell_t tape_main_memory[BASICFUCK_MEMORY_SIZE] = {0};
+// The cells of the tape that can currently be accessed directly, and pointer to
+// one after the end of them.
+static cell_t*       basicfuck_memory     = tape_main_memory;
+static const cell_t* basicfuck_memory_end = tape_main_memory +
+    BASICFUCK_MEMORY_SIZE;
+// Banked builds clear all of their memory up front, so moves can go all the
+// way to the end of the window. See Memory Clearing.
+#define tape_move_end basicfuck_memory_end
+#else // BANKED_TAPE
+// BASICfuck memory, and pointer to one after the end of it. Allocated by
+// initializeMemory(). See Memory Clearing.
+static cell_t*       basicfuck_memory     = NULL;
+static const cell_t* basicfuck_memory_end = NULL;
+#endif
+
+// Interpreter state.
+// Converts between computer memory pointers and the 16-bit addresses they point
+// to. The host computer has no 6502 memory to point into, so it is emulated
+// there with an array.
+#ifdef __CC65__
+#  define CMEM_ADDRESS(pointer) ((uint16_t)(pointer))
+#  define CMEM_POINTER(address) ((uint8_t*)(address))
+#else // __CC65__
+static uint8_t computer_memory[UINT16_MAX + 1] = {0};
+#  define CMEM_ADDRESS(pointer) ((uint16_t)((pointer) - computer_memory))
+#  define CMEM_POINTER(address) (computer_memory + (address))
+#endif
+
+static const opcode_t* interpreter_program_pointer = NULL;
+#ifdef BANKED_TAPE
+static cell_t* interpreter_bfmem_pointer = tape_main_memory;
+#else // BANKED_TAPE
+static cell_t* interpreter_bfmem_pointer = NULL;
+#endif
+static uint8_t* interpreter_cmem_pointer = CMEM_POINTER(0);
+
+// Global variables for exchaning values with inline assembler.
+static uint8_t interpreter_register_a = 0;
+static uint8_t interpreter_register_x = 0;
+static uint8_t interpreter_register_y = 0;
+
+#ifdef REU
+////////////////////////////////////////////////////////////////////////////////
+// RAM Expansion Unit                                                         //
+////////////////////////////////////////////////////////////////////////////////
+
+// A Commodore 17xx RAM Expansion Unit copies between computer memory and its own
+// memory with DMA, a byte every cycle, while the CPU waits, which is several
+// times faster than a loop on the CPU. It can also hold either address in place,
+// which fills a range with a single byte. It's used to clear BASICfuck memory,
+// to keep a snapshot of it, and, with BANKED_TAPE, to extend it.
+// On the C128, DMA goes to RAM bank 0, which is where cc65 programs live.
+#define REU_STASH   0x00 // Computer memory to REU.
+#define REU_FETCH   0x01 // REU to computer memory.
+#define REU_FIX_C64 0x80 // Address control: hold the computer memory address.
+#define REU_FIX_REU 0x40 // Address control: hold the REU address.
+#ifdef __CC65__
+// The registers, at $DF00 on both the C64 and C128.
+#  define REU_COMMAND         (*(volatile uint8_t*)0xDF01)
+#  define REU_C64_ADDRESS     (*(volatile uint16_t*)0xDF02)
+#  define REU_REU_ADDRESS     (*(volatile uint16_t*)0xDF04)
+#  define REU_REU_BANK        (*(volatile uint8_t*)0xDF06)
+#  define REU_LENGTH          (*(volatile uint16_t*)0xDF07)
+#  define REU_ADDRESS_CONTROL (*(volatile uint8_t*)0xDF0A)
+// Starts the transfer as soon as the command is written.
+#  define REU_EXECUTE         0x90
+// The tape is extended into the REU, after which the snapshot is kept.
+#  ifdef BANKED_TAPE
+#    define REU_TAPE
+#  endif
+#else // __CC65__
+// Emulated with an array, like computer memory, so it can be tried out.
+#  define REU_HOST_SIZE 0x20000UL
+static uint8_t reu_host_memory[REU_HOST_SIZE] = {0};
+#endif
+
+// The REU needs room for the snapshot of BASICfuck memory in main memory,
+// followed by a byte that is kept at 0 for clearing computer memory.
+#define REU_SNAPSHOT_SIZE (BASICFUCK_MEMORY_SIZE * sizeof(cell_t))
+
+// Whether an REU was found by initializeReu().
+static bool          reu_present          = false;
+// The REU address of the snapshot. With REU_TAPE, set by initializeTape() to
+// after the tape.
+static unsigned long reu_snapshot_address = 0;
+// Whether the snapshot has been taken yet.
+static bool          reu_snapshot_taken   = false;
+// A byte of computer memory that is always 0, for clearing the REU.
+static uint8_t       reu_zero             = 0;
+
+// A one-time-call function used to find the REU. Its address registers read
+// back what was written to them, unlike the empty space there without one.
+static void initializeReu(void) {
+#ifdef __CC65__
+    REU_C64_ADDRESS = 0x55AA;
+    REU_REU_ADDRESS = 0xAA55;
+    reu_present     = 0x55AA == REU_C64_ADDRESS && 0xAA55 == REU_REU_ADDRESS;
+#else // __CC65__
+    reu_present = true;
+#endif
+}
+
+// Copies length bytes, which must not be 0, between the computer memory at
+// pointer and the REU memory at address, in the direction given by transfer,
+// either REU_STASH or REU_FETCH. control is any of REU_FIX_C64 and REU_FIX_REU.
+static void reuTransfer(
+    const uint8_t       transfer,
+    void *const         pointer,
+    const unsigned long address,
+    const uint16_t      length,
+    const uint8_t       control
+) {
+#ifdef __CC65__
+    REU_C64_ADDRESS     = (uint16_t)pointer;
+    REU_REU_ADDRESS     = (uint16_t)address;
+    REU_REU_BANK        = (uint8_t)(address >> 16);
+    REU_LENGTH          = length;
+    REU_ADDRESS_CONTROL = control;
+    // The CPU is stopped until it's done.
+    REU_COMMAND         = REU_EXECUTE | transfer;
+#else // __CC65__
+    uint8_t*      c64_pointer = pointer;
+    unsigned long reu_address = address;
+    uint16_t      i           = 0;
+
+    for (; i < length; ++i) {
+        assert(reu_address < REU_HOST_SIZE);
+        if (REU_STASH == transfer) {
+            reu_host_memory[reu_address] = *c64_pointer;
+        } else {
+            *c64_pointer = reu_host_memory[reu_address];
+        }
+        if (0 == (control & REU_FIX_C64)) ++c64_pointer;
+        if (0 == (control & REU_FIX_REU)) ++reu_address;
+    }
+#endif
+}
+
+// Sets size bytes, which must not be 0, of computer memory at pointer to 0.
+static void reuClearMemory(void *const pointer, const uint16_t size) {
+    const unsigned long zero_address = reu_snapshot_address + REU_SNAPSHOT_SIZE;
+
+    // Computer memory can only be filled from the REU, so the 0 goes there
+    // first.
+    reuTransfer(REU_STASH, &reu_zero, zero_address, 1, 0);
+    reuTransfer(REU_FETCH, pointer, zero_address, size, REU_FIX_REU);
+}
+
+#ifdef REU_TAPE
+// Sets size bytes of REU memory at address to 0.
+static void reuClear(unsigned long address, unsigned long size) {
+    uint16_t length = 0;
+
+    while (0 != size) {
+        length = size > 0x8000 ? 0x8000 : (uint16_t)size;
+        reuTransfer(REU_STASH, &reu_zero, address, length, REU_FIX_C64);
+        address += length;
+        size    -= length;
+    }
+}
+#endif
+#endif // REU
+
+#ifdef BANKED_TAPE
+////////////////////////////////////////////////////////////////////////////////
+// Banked Tape                                                                //
+////////////////////////////////////////////////////////////////////////////////
+
+// The tape is made of the cells in main memory, followed by banks of extended
+// memory, only one of which can be accessed directly at a time. The window,
+// from basicfuck_memory to basicfuck_memory_end, is either main memory or the
+// current bank. The interpreter treats the edges of the window like the edges of
+// memory, only calling in here to step into the next window once it gets there,
+// so nothing is switched while a program stays inside a bank.
+#if defined(__CX16__)
+// The banks of RAM at $A000, after bank 0, which the KERNAL uses.
+#  define TAPE_BANK_SIZE (0x2000 / sizeof(cell_t))
+#elif defined(REU_TAPE)
+// The pages of the REU, given by cc65's extended memory driver, which moves them
+// in and out of computer memory with DMA. The pages after the tape are kept for
+// the REU's other uses. See RAM Expansion Unit.
+#  include <em.h>
+#  define TAPE_BANK_SIZE (256 / sizeof(cell_t))
+#  ifdef __C128__
+#    define TAPE_EM_DRIVER c128_reu_emd
+#  else // __C128__
+#    define TAPE_EM_DRIVER c64_reu_emd
+#  endif
+#  define TAPE_REU_RESERVED_PAGES ((REU_SNAPSHOT_SIZE + 1 + 255) / 256)
+#elif defined(__C128__) || defined(__ATARIXL__)
+// The pages of extended memory given by cc65's extended memory driver, for RAM
+// bank 1 on the C128 and the extra banks of 130XE compatible memory on the
+// Atari XL.
+#  include <em.h>
+#  define TAPE_BANK_SIZE (256 / sizeof(cell_t))
+#  ifdef __C128__
+#    define TAPE_EM_DRIVER c128_ram_emd
+#  else // __C128__
+#    define TAPE_EM_DRIVER atrx130_emd
+#  endif
+#elif !defined(__CC65__)
+// Emulated with an array, like computer memory, so it can be tried out.
+#  define TAPE_BANK_SIZE (256 / sizeof(cell_t))
+#  define TAPE_HOST_BANK_COUNT 64
+static cell_t tape_host_banks[TAPE_HOST_BANK_COUNT][TAPE_BANK_SIZE] = {0};
+#else
+#  error banked tape not supported for build target
+#endif
+
+typedef unsigned long tape_position_t;
+
+// The number of banks of extended memory, found by initializeTape().
+static uint16_t        tape_bank_count = 0;
+// The number of cells in the whole tape.
+static tape_position_t tape_size       = BASICFUCK_MEMORY_SIZE;
+// The window, 0 for main memory, or the number of the bank, counting from 1.
+static uint16_t        tape_window     = 0;
+
+// A one-time-call function used to find the extended memory for the tape.
+static void initializeTape(void) {
+#if defined(__CX16__)
+    const unsigned short bank_count = get_numbanks();
+
+    tape_bank_count = bank_count > 256 ? 255 : bank_count - 1;
+#elif defined(REU_TAPE)
+    if (EM_ERR_OK == em_install(&TAPE_EM_DRIVER)) {
+        if (em_pagecount() > TAPE_REU_RESERVED_PAGES) {
+            tape_bank_count = em_pagecount() - TAPE_REU_RESERVED_PAGES;
+        }
+        reu_snapshot_address = (unsigned long)tape_bank_count * 256;
+    }
+#elif defined(TAPE_EM_DRIVER)
+    if (EM_ERR_OK == em_install(&TAPE_EM_DRIVER)) {
+        tape_bank_count = em_pagecount();
+    }
+#else
+    tape_bank_count = TAPE_HOST_BANK_COUNT;
+#endif
+    tape_size += (tape_position_t)tape_bank_count * TAPE_BANK_SIZE;
+}
+
+// Removes what initializeTape() set up.
+static void deinitializeTape(void) {
+#ifdef TAPE_EM_DRIVER
+    if (0 != tape_bank_count) em_uninstall();
+#endif
+}
+
+// Switches the window to the given one.
+// basicfuck_memory, basicfuck_memory_end (global) - set to the window.
+static void tapeSelectWindow(const uint16_t window) {
+#ifdef TAPE_EM_DRIVER
+    // Writes back the changes to the bank that was mapped.
+    if (0 != tape_window) em_commit();
+#endif
+
+    tape_window = window;
+    if (0 == window) {
+        basicfuck_memory     = tape_main_memory;
+        basicfuck_memory_end = tape_main_memory + BASICFUCK_MEMORY_SIZE;
+        return;
+    }
+
+#if defined(__CX16__)
+    RAM_BANK         = (uint8_t)window;
+    basicfuck_memory = (cell_t*)BANK_RAM;
+#elif defined(TAPE_EM_DRIVER)
+    basicfuck_memory = em_map(window - 1);
+#else
+    basicfuck_memory = tape_host_banks[window - 1];
+#endif
+    basicfuck_memory_end = basicfuck_memory + TAPE_BANK_SIZE;
+}
+
+// Sets the cells in the banks of extended memory to 0. The window must be main
+// memory.
+static void tapeClearBanks(void) {
+#if defined(__CX16__)
+    const uint8_t saved_bank = RAM_BANK;
+    uint16_t      bank       = 1;
+
+    for (; bank <= tape_bank_count; ++bank) {
+        RAM_BANK = (uint8_t)bank;
+        memset(BANK_RAM, 0, 0x2000);
+    }
+    RAM_BANK = saved_bank;
+#elif defined(REU_TAPE)
+    reuClear(0, (unsigned long)tape_bank_count * 256);
+#elif defined(TAPE_EM_DRIVER)
+    uint16_t page = 0;
+
+    for (; page < tape_bank_count; ++page) {
+        memset(em_use(page), 0, 256);
+        em_commit();
+    }
+#else
+    memset(tape_host_banks, 0, sizeof(tape_host_banks));
+#endif
+}
+
+// Returns the position of the current cell on the tape.
+static tape_position_t tapePosition(void) {
+    const uint16_t index =
+        (uint16_t)(interpreter_bfmem_pointer - basicfuck_memory);
+
+    if (0 == tape_window) return index;
+    return BASICFUCK_MEMORY_SIZE
+           + (tape_position_t)(tape_window - 1) * TAPE_BANK_SIZE + index;
+}
+
+// Moves the cell pointer to the given position on the tape, switching windows if
+// needed.
+static void tapeSeek(tape_position_t position) {
+    uint16_t window = 0;
+
+    if (position >= BASICFUCK_MEMORY_SIZE) {
+        position -= BASICFUCK_MEMORY_SIZE;
+        window    = (uint16_t)(position / TAPE_BANK_SIZE) + 1;
+        position %= TAPE_BANK_SIZE;
+    }
+    if (window != tape_window) tapeSelectWindow(window);
+
+    interpreter_bfmem_pointer = basicfuck_memory + (uint16_t)position;
+}
+
+// Moves the cell pointer by the given distance, switching windows if needed, or
+// stays put if that would leave the tape.
+// Returns whether it moved.
+static bool tapeMove(const int16_t distance) {
+    tape_position_t position = tapePosition();
+
+    if (distance < 0) {
+        if (position < (uint16_t)-distance) return false;
+        tapeSeek(position - (uint16_t)-distance);
+        return true;
+    }
+
+    if (position + (uint16_t)distance >= tape_size) return false;
+    tapeSeek(position + (uint16_t)distance);
+    return true;
+}
+
+// The position on the tape found by tapeFindOffset(), for tapeRead() and
+// tapeWrite().
+static tape_position_t tape_access_position = 0;
+
+// Finds the cell at the given offset from the current one, which may be outside
+// of the window.
+// Returns false if it is outside of the tape.
+static bool tapeFindOffset(const int8_t offset) {
+    const tape_position_t position = tapePosition();
+
+    if (offset < 0 && position < (uint8_t)-offset) return false;
+    tape_access_position = position + offset;
+    return tape_access_position < tape_size;
+}
+
+// Reads the cell found by tapeFindOffset(), without switching windows.
+static cell_t tapeRead(void) {
+    tape_position_t index = tape_access_position;
+    uint16_t        bank  = 0;
+    cell_t          value = 0;
+#ifdef __CX16__
+    uint8_t         saved_bank = 0;
+#elif defined(TAPE_EM_DRIVER)
+    struct em_copy  copy;
+#endif
+
+    if (index < BASICFUCK_MEMORY_SIZE) return tape_main_memory[index];
+    index -= BASICFUCK_MEMORY_SIZE;
+    bank   = (uint16_t)(index / TAPE_BANK_SIZE) + 1;
+    index %= TAPE_BANK_SIZE;
+    if (bank == tape_window) return basicfuck_memory[index];
+
+#if defined(__CX16__)
+    saved_bank = RAM_BANK;
+    RAM_BANK   = (uint8_t)bank;
+    value      = ((cell_t*)BANK_RAM)[index];
+    RAM_BANK   = saved_bank;
+#elif defined(TAPE_EM_DRIVER)
+    copy.buf   = &value;
+    copy.offs  = (uint8_t)(index * sizeof(cell_t));
+    copy.page  = bank - 1;
+    copy.count = sizeof(cell_t);
+    em_copyfrom(&copy);
+#else
+    value = tape_host_banks[bank - 1][index];
+#endif
+    return value;
+}
+
+// Writes to the cell found by tapeFindOffset(), without switching windows.
+static void __fastcall__ tapeWrite(cell_t value) {
+    tape_position_t index = tape_access_position;
+    uint16_t        bank  = 0;
+#ifdef __CX16__
+    uint8_t         saved_bank = 0;
+#elif defined(TAPE_EM_DRIVER)
+    struct em_copy  copy;
+#endif
+
+    if (index < BASICFUCK_MEMORY_SIZE) {
+        tape_main_memory[index] = value;
+        return;
+    }
+    index -= BASICFUCK_MEMORY_SIZE;
+    bank   = (uint16_t)(index / TAPE_BANK_SIZE) + 1;
+    index %= TAPE_BANK_SIZE;
+    if (bank == tape_window) {
+        basicfuck_memory[index] = value;
+        return;
+    }
+
+#if defined(__CX16__)
+    saved_bank = RAM_BANK;
+    RAM_BANK   = (uint8_t)bank;
+    ((cell_t*)BANK_RAM)[index] = value;
+    RAM_BANK   = saved_bank;
+#elif defined(TAPE_EM_DRIVER)
+    copy.buf   = &value;
+    copy.offs  = (uint8_t)(index * sizeof(cell_t));
+    copy.page  = bank - 1;
+    copy.count = sizeof(cell_t);
+    em_copyto(&copy);
+#else
+    tape_host_banks[bank - 1][index] = value;
+#endif
+}
+#endif // BANKED_TAPE
+
+////////////////////////////////////////////////////////////////////////////////
+// Memory Clearing                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+// Sets size bytes, which must not be 0, of BASICfuck memory at pointer to 0.
+static void clearCells(cell_t *const pointer, const uint16_t size) {
+#ifdef REU
+    if (reu_present) {
+        reuClearMemory(pointer, size);
+        return;
+    }
+#endif
+    memset(pointer, 0, size);
+}
+
+#ifndef BANKED_TAPE
+// BASICfuck memory is allocated on startup, instead of being a static array,
+// since the startup code would otherwise spend a while setting all of it to 0.
+// Only the cells from the start up to tape_clean_end have been cleared, and the
+// rest are cleared as the cell pointer nears them: moves to the right past
+// tape_move_end call tapeClean() first. The cell pointer starts on, and can't
+// move to the left of, the first cell, so the cells it has touched always run
+// from there up to tape_clean_end, which is all that CLR has to clear.
+// Must call initializeMemory() once prior to use.
+
+// The number of cells kept cleared past tape_move_end, for the instructions
+// that work on cells at a signed 8-bit offset from the current one.
+#define TAPE_CLEAN_MARGIN 128U
+// The number of cells cleared past what is needed, so a program moving right
+// one cell at a time doesn't clear one cell at a time.
+#define TAPE_CLEAN_STEP   256U
+
+// One after the last cleared cell.
+static const cell_t* tape_clean_end = NULL;
+// The cell pointer is kept before this, TAPE_CLEAN_MARGIN cells before
+// tape_clean_end, or the end of BASICfuck memory once all of it is cleared.
+static const cell_t* tape_move_end  = NULL;
+#ifdef NATIVE_CODE
+// The high byte of the lowest address from which native code could move the
+// cell pointer up to 255 cells to the right and end up past tape_move_end.
+static uint8_t       tape_move_page = 0;
+#endif
+
+// Marks the cells before the given position in BASICfuck memory as cleared,
+// and the rest as not, which must leave the cell pointer before tape_move_end.
+// The position must be at least TAPE_CLEAN_MARGIN, unless it is the end of
+// BASICfuck memory.
+static void __fastcall__ tapeMarkClean(const uint16_t end) {
+    tape_clean_end = basicfuck_memory + end;
+    tape_move_end  = BASICFUCK_MEMORY_SIZE == end ? basicfuck_memory_end
+                     : tape_clean_end - TAPE_CLEAN_MARGIN;
+#ifdef NATIVE_CODE
+    tape_move_page = (uint8_t)(((uint16_t)tape_move_end - UINT8_MAX) >> 8);
+#endif
+}
+
+// Clears the cells needed for the cell pointer to be moved to the given cell,
+// along with TAPE_CLEAN_STEP more, moving tape_move_end past it, unless that
+// would be past the end of BASICfuck memory.
+// Returns tape_move_end, for the assembly interpreter.
+static const cell_t* __fastcall__ tapeClean(const cell_t *const target) {
+    const uint16_t clean = (uint16_t)(tape_clean_end - basicfuck_memory);
+    uint16_t       end   = (uint16_t)(target - basicfuck_memory);
+
+    if (end + TAPE_CLEAN_MARGIN + TAPE_CLEAN_STEP < BASICFUCK_MEMORY_SIZE) {
+        end += TAPE_CLEAN_MARGIN + TAPE_CLEAN_STEP;
+    } else {
+        end  = BASICFUCK_MEMORY_SIZE;
+    }
+    if (end > clean) {
+        clearCells(basicfuck_memory + clean, (end - clean) * sizeof(cell_t));
+        tapeMarkClean(end);
+    }
+    return tape_move_end;
+}
+
+// A one-time-call function used to allocate BASICfuck memory, and clear the
+// start of it.
+// Returns false if there isn't enough memory.
+static bool initializeMemory(void) {
+    basicfuck_memory = malloc(BASICFUCK_MEMORY_SIZE * sizeof(cell_t));
+    if (NULL == basicfuck_memory) return false;
+    basicfuck_memory_end      = basicfuck_memory + BASICFUCK_MEMORY_SIZE;
+    interpreter_bfmem_pointer = basicfuck_memory;
+
+    // Nothing is cleared yet. tapeClean() only needs to know where clearing
+    // starts, and sets up the rest.
+    tape_clean_end = basicfuck_memory;
+    tapeClean(basicfuck_memory);
+    return true;
+}
+#endif // BANKED_TAPE
+
+// Runs the execute part of the BASICfuck execute instruction.
+// interpreter_register_a (global) - the value to place in the A register.
+// interpreter_register_x (global) - the value to place in the X register.
+// interpreter_register_y (global) - the value to place in the Y register.
+// interpreter_cmem_pointer (global) - the address to execute as a subroutine.
+#ifdef __CC65__
+static void basicfuckExecute(void) {
+    // Overwrites address of subroutine to call in next assembly block with the
+    // computer memory pointer's value.
+    __asm__ volatile ("lda %v",   interpreter_cmem_pointer);
+    __asm__ volatile ("sta %g+1", ljump_instruction);
+    __asm__ volatile ("lda %v+1", interpreter_cmem_pointer);
+    __asm__ volatile ("sta %g+2", ljump_instruction);
+    // Executes subroutine.
+    __asm__ volatile ("lda %v", interpreter_register_a);
+    __asm__ volatile ("ldx %v", interpreter_register_x);
+    __asm__ volatile ("ldy %v", interpreter_register_y);
+ljump_instruction:
+    __asm__ volatile ("jsr %w", NULL);
+    // Retrieves resuting values.
+    __asm__ volatile ("sta %v", interpreter_register_a);
+    __asm__ volatile ("stx %v", interpreter_register_x);
+    __asm__ volatile ("sty %v", interpreter_register_y);
+
+    return;
+    // If we don't include a jmp instruction, cc65, annoyingly, strips the label
+    // from the resulting assembly.
+    __asm__ volatile ("jmp %g", ljump_instruction);
+}
+#else // __CC65__
+// There is no 6502 to run the subroutine on when running on the host computer,
+// so this leaves the registers as they are.
+static void basicfuckExecute(void) {}
+#endif
+
+#ifdef BANKED_TAPE
+// Runs the BASICfuck execute instruction when the next two cells aren't both in
+// the window.
+// Returns false, without running it, if they run past the end of the tape.
+static bool tapeExecute(void) {
+    if (!tapeFindOffset(2)) return false;
+    interpreter_register_y = tapeRead();
+    tapeFindOffset(1);
+    interpreter_register_x = tapeRead();
+    interpreter_register_a = *interpreter_bfmem_pointer;
+    basicfuckExecute();
+    // The subroutine may have printed.
+    outputSync();
+    *interpreter_bfmem_pointer = interpreter_register_a;
+    tapeFindOffset(1);
+    tapeWrite(interpreter_register_x);
+    tapeFindOffset(2);
+    tapeWrite(interpreter_register_y);
+    return true;
+}
+#endif
+
+// Checking for STOP is slow compared to running an instruction, so it is only
+// done when looping back, and only every this many times. Must match
+// STOP_POLL_INTERVAL in baf-interpreter.s.
+#define STOP_POLL_INTERVAL 16
+
+// Returns true, and prints an abort message, if STOP was pressed.
+static bool pollStop(void) {
+    if (typeAheadStopPressed()) {
+        puts("?ABORT");
+        return true;
+    }
+    return false;
+}
+
+#ifdef PROFILER
+// The number of times the instruction at each offset in program memory was run
+// by the last program, stopping at UINT16_MAX.
+static uint16_t profiler_counts[PROGRAM_MEMORY_SIZE] = {0};
+#endif
+
+#ifndef ASSEMBLY_INTERPRETER
+// Runs the interpreter with the given bytecode-compiled BASICfuck program.
+// interpreter_bfmem_pointer (global) - the current BASICfuck memory pointer.
+// interpreter_cmem_pointer (global) - the current computer memory pointer.
+// profiler_counts (global) - counts of instructions run, if PROFILER is
+// defined.
+static void interpret(void) {
+    opcode_t  opcode         = 0;
+    uint8_t   argument       = 0;
+    cell_t*   target_pointer = NULL;
+    cell_t*   limit_pointer  = NULL;
+    opcode_t* string_pointer = NULL;
+    uint8_t   poll_countdown = STOP_POLL_INTERVAL;
+#ifdef PROFILER
+    uint16_t* count_pointer  = NULL;
+#endif
+
+    static const void *const jump_table[] = {
+        &&lopcode_halt,                  // OPCODE_HALT.
+        &&lopcode_increment,             // OPCODE_INCREMENT.
+        &&lopcode_decrement,             // OPCODE_DECREMENT.
+        &&lopcode_bfmem_left,            // OPCODE_BFMEM_LEFT.
+        &&lopcode_bfmem_right,           // OPCODE_BFMEM_RIGHT.
+        &&lopcode_print,                 // OPCODE_PRINT.
+        &&lopcode_input,                 // OPCODE_INPUT.
+        &&lopcode_jeq,                   // OPCODE_JEQ.
+        &&lopcode_jne,                   // OPCODE_JNE.
+        &&lopcode_cmem_read,             // OPCODE_CMEM_READ.
+        &&lopcode_cmem_write,            // OPCODE_CMEM_WRITE.
+        &&lopcode_cmem_left,             // OPCODE_CMEM_LEFT.
+        &&lopcode_cmem_right,            // OPCODE_CMEM_RIGHT.
+        &&lopcode_execute,               // OPCODE_EXECUTE.
+        &&lopcode_set_zero,              // OPCODE_SET_ZERO.
+        &&lopcode_multiply_add,          // OPCODE_MULTIPLY_ADD.
+        &&lopcode_scan_left,             // OPCODE_SCAN_LEFT.
+        &&lopcode_scan_right,            // OPCODE_SCAN_RIGHT.
+        &&lopcode_add_at,                // OPCODE_ADD_AT.
+        &&lopcode_print_at,              // OPCODE_PRINT_AT.
+        &&lopcode_set_zero_at,           // OPCODE_SET_ZERO_AT.
+        &&lopcode_jeq_short,             // OPCODE_JEQ_SHORT.
+        &&lopcode_jne_short,             // OPCODE_JNE_SHORT.
+        &&lopcode_check_bounds,          // OPCODE_CHECK_BOUNDS.
+        &&lopcode_bfmem_left_unchecked,  // OPCODE_BFMEM_LEFT_UNCHECKED.
+        &&lopcode_bfmem_right_unchecked, // OPCODE_BFMEM_RIGHT_UNCHECKED.
+        &&lopcode_print_string           // OPCODE_PRINT_STRING.
+    };
+
+    // Initialize interpreter.
+    interpreter_program_pointer = program_memory;
+#ifdef PROFILER
+    memset(profiler_counts, 0, sizeof(profiler_counts));
+#endif
+
+    while (true) {
+        opcode   = *interpreter_program_pointer;
+        argument = interpreter_program_pointer[1];
+#ifdef PROFILER
+        count_pointer =
+            &profiler_counts[interpreter_program_pointer - program_memory];
+        if (UINT16_MAX != *count_pointer) ++*count_pointer;
+#endif
+        assert(opcode < ARRAY_SIZE(jump_table) && "unreachable");
+        goto *jump_table[opcode];
+
+lopcode_halt: {
+            break;
         }
 
 lopcode_increment: {
@@ -803,104 +2808,1489 @@ lopcode_increment: {
             goto lfinish_interpreter_cycle;
         }
 
-lopcode_decrement: {
-            *interpreter_bfmem_pointer -= argument;
+lopcode_decrement: {
+            *interpreter_bfmem_pointer -= argument;
+            goto lfinish_interpreter_cycle;
+        }
+
+lopcode_bfmem_left: {
+            if (interpreter_bfmem_pointer >= basicfuck_memory + argument) {
+                interpreter_bfmem_pointer -= argument;
+            }
+#ifdef BANKED_TAPE
+            else if (!tapeMove(-(int16_t)argument)) {
+                goto lout_of_bounds;
+            }
+#else // BANKED_TAPE
+            else {
+                goto lout_of_bounds;
+            }
+#endif
+            goto lfinish_interpreter_cycle;
+        }
+
+lopcode_bfmem_right: {
+            if (interpreter_bfmem_pointer + argument < tape_move_end) {
+                interpreter_bfmem_pointer += argument;
+            }
+#ifdef BANKED_TAPE
+            else if (!tapeMove(argument)) {
+                goto lout_of_bounds;
+            }
+#else // BANKED_TAPE
+            else if (interpreter_bfmem_pointer + argument
+                     < basicfuck_memory_end) {
+                tapeClean(interpreter_bfmem_pointer + argument);
+                interpreter_bfmem_pointer += argument;
+            } else {
+                goto lout_of_bounds;
+            }
+#endif
+            goto lfinish_interpreter_cycle;
+        }
+
+lopcode_print: {
+            outputCharacter(*interpreter_bfmem_pointer);
+            goto lfinish_interpreter_cycle;
+        }
+
+lopcode_input: {
+            argument = typeAheadGet();
+            if (KEYBOARD_STOP == argument) {
+                puts("?ABORT");
+                break;
+            };
+            *interpreter_bfmem_pointer = argument;
+            goto lfinish_interpreter_cycle;
+        }
+
+lopcode_jeq: {
+            if (0 == *interpreter_bfmem_pointer) {
+                interpreter_program_pointer =
+                    GET_JUMP_TARGET(interpreter_program_pointer);
+            }
+            goto lfinish_interpreter_cycle;
+        }
+
+lopcode_jne: {
+            if (0 != *interpreter_bfmem_pointer) {
+                interpreter_program_pointer =
+                    GET_JUMP_TARGET(interpreter_program_pointer);
+
+                if (0 == --poll_countdown) {
+                    poll_countdown = STOP_POLL_INTERVAL;
+                    if (pollStop()) break;
+                }
+            }
+            goto lfinish_interpreter_cycle;
+        }
+
+lopcode_cmem_read: {
+            *interpreter_bfmem_pointer = *interpreter_cmem_pointer;
+            goto lfinish_interpreter_cycle;
+        }
+
+lopcode_cmem_write: {
+            *interpreter_cmem_pointer = *interpreter_bfmem_pointer;
+            goto lfinish_interpreter_cycle;
+        }
+
+lopcode_cmem_left: {
+            if (CMEM_ADDRESS(interpreter_cmem_pointer) > argument) {
+                interpreter_cmem_pointer -= argument;
+            } else {
+                interpreter_cmem_pointer = CMEM_POINTER(0);
+            }
+            goto lfinish_interpreter_cycle;
+        }
+
+lopcode_cmem_right: {
+            if (UINT16_MAX - CMEM_ADDRESS(interpreter_cmem_pointer) > argument) {
+                interpreter_cmem_pointer += argument;
+            } else {
+                interpreter_cmem_pointer = CMEM_POINTER(UINT16_MAX);
+            }
+            goto lfinish_interpreter_cycle;
+        }
+
+        // The registers are also taken from the next two cells, so those must
+        // be inside of BASICfuck memory too.
+lopcode_execute: {
+            if (interpreter_bfmem_pointer + 2 >= basicfuck_memory_end) {
+#ifdef BANKED_TAPE
+                // The next cells may be in the next window.
+                if (tapeExecute()) goto lfinish_interpreter_cycle;
+#endif
+                goto lout_of_bounds;
+            }
+            interpreter_register_a = *interpreter_bfmem_pointer;
+            interpreter_register_x = interpreter_bfmem_pointer[1];
+            interpreter_register_y = interpreter_bfmem_pointer[2];
+            basicfuckExecute();
+            // The subroutine may have printed.
+            outputSync();
+            *interpreter_bfmem_pointer   = interpreter_register_a;
+            interpreter_bfmem_pointer[1] = interpreter_register_x;
+            interpreter_bfmem_pointer[2] = interpreter_register_y;
+            goto lfinish_interpreter_cycle;
+        }
+
+lopcode_set_zero: {
+            *interpreter_bfmem_pointer = 0;
+            goto lfinish_interpreter_cycle;
+        }
+
+        // The loop a multiply replaced doesn't run when the current cell is 0,
+        // so it can only leave BASICfuck memory when it isn't.
+lopcode_multiply_add: {
+            target_pointer = interpreter_bfmem_pointer + (int8_t)argument;
+            if (target_pointer >= basicfuck_memory
+                    && target_pointer < basicfuck_memory_end) {
+                *target_pointer +=
+                    *interpreter_bfmem_pointer
+                    * GET_CELL_ARGUMENT(interpreter_program_pointer + 2);
+            }
+#ifdef BANKED_TAPE
+            else if (tapeFindOffset((int8_t)argument)) {
+                tapeWrite(
+                    tapeRead()
+                    + *interpreter_bfmem_pointer
+                    * GET_CELL_ARGUMENT(interpreter_program_pointer + 2)
+                );
+            }
+#endif
+            else if (0 != *interpreter_bfmem_pointer) {
+                goto lout_of_bounds;
+            }
             goto lfinish_interpreter_cycle;
         }
 
-lopcode_bfmem_left: {
-            if (interpreter_bfmem_pointer > basicfuck_memory + argument) {
+lopcode_scan_left: {
+            limit_pointer = basicfuck_memory + argument;
+            while (0 != *interpreter_bfmem_pointer
+                    && interpreter_bfmem_pointer >= limit_pointer) {
                 interpreter_bfmem_pointer -= argument;
-            } else {
-                interpreter_bfmem_pointer = basicfuck_memory;
+            }
+            if (0 != *interpreter_bfmem_pointer) {
+#ifdef BANKED_TAPE
+                // Carries on from the previous window.
+                if (tapeMove(-(int16_t)argument)) continue;
+#endif
+                goto lout_of_bounds;
             }
             goto lfinish_interpreter_cycle;
         }
 
-lopcode_bfmem_right: {
-            if (interpreter_bfmem_pointer + argument < basicfuck_memory_end) {
+lopcode_scan_right: {
+            limit_pointer = (cell_t*)tape_move_end - argument;
+            while (0 != *interpreter_bfmem_pointer
+                    && interpreter_bfmem_pointer < limit_pointer) {
                 interpreter_bfmem_pointer += argument;
             }
+            if (0 != *interpreter_bfmem_pointer) {
+#ifdef BANKED_TAPE
+                // Carries on from the next window.
+                if (tapeMove(argument)) continue;
+#else // BANKED_TAPE
+                // Carries on once more memory is cleared.
+                if (tape_move_end != basicfuck_memory_end) {
+                    tapeClean(interpreter_bfmem_pointer + argument);
+                    continue;
+                }
+#endif
+                goto lout_of_bounds;
+            }
             goto lfinish_interpreter_cycle;
         }
 
-lopcode_print: {
-            putchar(*interpreter_bfmem_pointer);
+lopcode_add_at: {
+            target_pointer = interpreter_bfmem_pointer + (int8_t)argument;
+            if (target_pointer >= basicfuck_memory
+                    && target_pointer < basicfuck_memory_end) {
+                *target_pointer +=
+                    GET_CELL_ARGUMENT(interpreter_program_pointer + 2);
+            }
+#ifdef BANKED_TAPE
+            else if (tapeFindOffset((int8_t)argument)) {
+                tapeWrite(
+                    tapeRead() + GET_CELL_ARGUMENT(interpreter_program_pointer + 2)
+                );
+            }
+#endif
+            else {
+                goto lout_of_bounds;
+            }
             goto lfinish_interpreter_cycle;
         }
 
-lopcode_input: {
-            argument = wrappedCgetc();
-            if (KEYBOARD_STOP == argument) {
-                puts("?ABORT");
-                break;
-            };
-            *interpreter_bfmem_pointer = argument;
+lopcode_print_at: {
+            target_pointer = interpreter_bfmem_pointer + (int8_t)argument;
+            if (target_pointer >= basicfuck_memory
+                    && target_pointer < basicfuck_memory_end) {
+                outputCharacter(*target_pointer);
+            }
+#ifdef BANKED_TAPE
+            else if (tapeFindOffset((int8_t)argument)) {
+                outputCharacter(tapeRead());
+            }
+#endif
+            else {
+                goto lout_of_bounds;
+            }
+            goto lfinish_interpreter_cycle;
+        }
+
+lopcode_set_zero_at: {
+            target_pointer = interpreter_bfmem_pointer + (int8_t)argument;
+            if (target_pointer >= basicfuck_memory
+                    && target_pointer < basicfuck_memory_end) {
+                *target_pointer = 0;
+            }
+#ifdef BANKED_TAPE
+            else if (tapeFindOffset((int8_t)argument)) {
+                tapeWrite(0);
+            }
+#endif
+            else {
+                goto lout_of_bounds;
+            }
+            goto lfinish_interpreter_cycle;
+        }
+
+lopcode_jeq_short: {
+            if (0 == *interpreter_bfmem_pointer) {
+                interpreter_program_pointer += (int8_t)argument;
+            }
+            goto lfinish_interpreter_cycle;
+        }
+
+lopcode_jne_short: {
+            if (0 != *interpreter_bfmem_pointer) {
+                interpreter_program_pointer += (int8_t)argument;
+
+                if (0 == --poll_countdown) {
+                    poll_countdown = STOP_POLL_INTERVAL;
+                    if (pollStop()) break;
+                }
+            }
+            goto lfinish_interpreter_cycle;
+        }
+
+lopcode_check_bounds: {
+            if (0 != *interpreter_bfmem_pointer
+                    && (interpreter_bfmem_pointer < basicfuck_memory + argument
+                        || interpreter_bfmem_pointer >= tape_move_end
+                           - interpreter_program_pointer[2])) {
+#ifndef BANKED_TAPE
+                // Checks again once more memory is cleared.
+                if (interpreter_bfmem_pointer >= basicfuck_memory + argument
+                        && tape_move_end != basicfuck_memory_end) {
+                    tapeClean(interpreter_bfmem_pointer
+                              + interpreter_program_pointer[2]);
+                    continue;
+                }
+#endif
+                goto lout_of_bounds;
+            }
+            goto lfinish_interpreter_cycle;
+        }
+
+lopcode_bfmem_left_unchecked: {
+            interpreter_bfmem_pointer -= argument;
+            goto lfinish_interpreter_cycle;
+        }
+
+lopcode_bfmem_right_unchecked: {
+            interpreter_bfmem_pointer += argument;
+            goto lfinish_interpreter_cycle;
+        }
+
+lopcode_print_string: {
+            string_pointer = GET_JUMP_TARGET(interpreter_program_pointer);
+            for (argument = interpreter_program_pointer[3]; argument > 0;
+                    --argument) {
+                outputCharacter(*(string_pointer++));
+            }
             goto lfinish_interpreter_cycle;
         }
 
-lopcode_jeq: {
-            if (0 == *interpreter_bfmem_pointer) {
-                interpreter_program_pointer =
-                    *(opcode_t**)(interpreter_program_pointer + 1);
+lout_of_bounds: {
+            // Jumped to when an instruction would leave BASICfuck memory.
+            puts("?OUT OF BOUNDS");
+            break;
+        }
+
+lfinish_interpreter_cycle: {
+            // Jumped to after an opcode has been executed.
+            interpreter_program_pointer += opcode_size_table[opcode];
+        }
+    }
+}
+#endif // ASSEMBLY_INTERPRETER
+
+////////////////////////////////////////////////////////////////////////////////
+// Program Store                                                              //
+////////////////////////////////////////////////////////////////////////////////
+
+// Numbered lines of BASICfuck, entered like in BASIC, and run together with the
+// RUN command. Each line is kept with the bytecode from its first pass of
+// compilation, so entering a line only compiles that line, and running the
+// program only needs to copy the bytecode together before the other passes.
+// Lines are stored in order of line number, one after another, each as:
+// - The line number, 16-bit little-endian.
+// - The size of the text, 8-bit.
+// - The size of the bytecode, 16-bit little-endian.
+// - The text, without a null-terminator.
+// - The bytecode, without OPCODE_HALT. Jumps are left unlinked.
+static uint8_t  program_store[PROGRAM_STORE_SIZE] = {0};
+// The number of bytes used in program_store[].
+static uint16_t program_store_size                = 0;
+// Whether the next program compiled should be the one in the program store.
+static bool     compiler_use_program_store        = false;
+
+#define STORED_LINE_HEADER_SIZE 5
+#define STORED_LINE_NUMBER(line) ((line)[0] | (uint16_t)(line)[1] << 8)
+#define STORED_LINE_TEXT_SIZE(line) ((line)[2])
+#define STORED_LINE_BYTECODE_SIZE(line) ((line)[3] | (uint16_t)(line)[4] << 8)
+#define STORED_LINE_TEXT(line) ((line) + STORED_LINE_HEADER_SIZE)
+#define STORED_LINE_BYTECODE(line)                                             \
+    (STORED_LINE_TEXT(line) + STORED_LINE_TEXT_SIZE(line))
+#define STORED_LINE_SIZE(line)                                                 \
+    (STORED_LINE_HEADER_SIZE + STORED_LINE_TEXT_SIZE(line)                     \
+     + STORED_LINE_BYTECODE_SIZE(line))
+
+// Reverses the order of the bytes from start up to, but not including, end.
+static void reverseBytes(uint8_t* start, uint8_t* end) {
+    uint8_t swap = 0;
+
+    while (start < --end) {
+        swap     = *start;
+        *start++ = *end;
+        *end     = swap;
+    }
+}
+
+// Stores the numbered line in the edit buffer in the program store, replacing
+// the line with the same number, or, if there is nothing after the number,
+// deletes it. Prints an error message if it couldn't be stored, leaving the
+// program store as it was.
+// edit_buffer (global) - the line, starting with the line number.
+// program_store, program_store_size (global) - the program store.
+static void storeLine(void) {
+    uint8_t* const program_store_end = program_store + program_store_size;
+    const uint8_t* text              = edit_buffer;
+    uint16_t       number            = 0;
+    uint8_t        digit             = 0;
+    uint8_t        text_size         = 0;
+    uint8_t*       line              = program_store;
+    uint8_t*       new_line          = program_store_end;
+    uint16_t       old_line_size     = 0;
+    uint16_t       new_line_size     = 0;
+
+    for (; *text >= '0' && *text <= '9'; ++text) {
+        digit = *text - '0';
+        if (number > (UINT16_MAX - digit) / 10) {
+            puts("?LINE NUMBER TOO LARGE");
+            return;
+        }
+        number = number * 10 + digit;
+    }
+    while (' ' == *text) ++text;
+    text_size = (uint8_t)strlen((const char*)text);
+
+    // Finds where the line goes.
+    while (line < program_store_end && STORED_LINE_NUMBER(line) < number) {
+        line += STORED_LINE_SIZE(line);
+    }
+    if (line < program_store_end && STORED_LINE_NUMBER(line) == number) {
+        old_line_size = STORED_LINE_SIZE(line);
+    }
+
+    // Builds the new line in the free space at the end, so nothing is lost if
+    // it doesn't fit.
+    if (0 != text_size) {
+        if ((uint16_t)(STORED_LINE_HEADER_SIZE + text_size)
+            >= PROGRAM_STORE_SIZE - program_store_size) {
+            puts("?OUT OF MEMORY");
+            return;
+        }
+        new_line[0] = (uint8_t)number;
+        new_line[1] = (uint8_t)(number >> 8);
+        new_line[2] = text_size;
+        memcpy(STORED_LINE_TEXT(new_line), text, text_size);
+
+        compiler_read_pointer      = text;
+        compiler_read_pointer_end  = NULL;
+        compiler_read_error        = false;
+        compiler_write_pointer     = STORED_LINE_BYTECODE(new_line);
+        compiler_write_pointer_end = program_store + PROGRAM_STORE_SIZE - 1;
+        if (NULL != compileInstructions()) {
+            puts("?OUT OF MEMORY");
+            return;
+        }
+        new_line_size = (uint16_t)(compiler_write_pointer - new_line);
+        new_line[3]   = (uint8_t)(new_line_size - STORED_LINE_HEADER_SIZE
+                                  - text_size);
+        new_line[4]   = (uint8_t)((new_line_size - STORED_LINE_HEADER_SIZE
+                                   - text_size) >> 8);
+    }
+
+    // Removes the old line, shifting down everything after it, along with the
+    // new line.
+    if (0 != old_line_size) {
+        memmove(
+            line,
+            line + old_line_size,
+            program_store_end + new_line_size - line - old_line_size
+        );
+        program_store_size -= old_line_size;
+        new_line           -= old_line_size;
+    }
+
+    // Rotates the new line into place.
+    if (0 != new_line_size) {
+        reverseBytes(line, new_line);
+        reverseBytes(new_line, new_line + new_line_size);
+        reverseBytes(line, new_line + new_line_size);
+        program_store_size += new_line_size;
+    }
+}
+
+// Performs the first pass of BASICfuck compilation for the program in the
+// program store, which, since its lines were already compiled when entered,
+// only copies their bytecode into program memory.
+// Returns an error message on failure, or NULL on success.
+// program_store, program_store_size (global) - the program store.
+static const char* compileProgramStore(void) {
+    const uint8_t* line          = program_store;
+    uint16_t       bytecode_size = 0;
+
+    compiler_write_pointer     = program_memory;
+    compiler_write_pointer_end = PROGRAM_MEMORY_SIZE - 1 + program_memory;
+
+    for (; line < program_store + program_store_size;
+            line += STORED_LINE_SIZE(line)) {
+        bytecode_size = STORED_LINE_BYTECODE_SIZE(line);
+        if (bytecode_size > compiler_write_pointer_end - compiler_write_pointer) {
+            return "?OUT OF MEMORY";
+        }
+        memcpy(compiler_write_pointer, STORED_LINE_BYTECODE(line), bytecode_size);
+        compiler_write_pointer += bytecode_size;
+    }
+    *compiler_write_pointer = OPCODE_HALT;
+
+    return NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Bytecode Cache                                                             //
+////////////////////////////////////////////////////////////////////////////////
+
+// The fully compiled bytecode of recently run lines, so running a line again,
+// like one recalled from the history, can skip compiling it. Entries are kept
+// one after another, from most to least recently run, each as:
+// - The hash of the text, 16-bit little-endian.
+// - The size of the text, 8-bit.
+// - The size of the bytecode, 16-bit little-endian.
+// - The text, without a null-terminator.
+// - The bytecode, with OPCODE_HALT. Jumps are linked for program memory.
+static uint8_t  bytecode_cache[BYTECODE_CACHE_SIZE] = {0};
+// The number of bytes used in bytecode_cache[].
+static uint16_t bytecode_cache_size                 = 0;
+
+#define CACHED_LINE_HEADER_SIZE 5
+#define CACHED_LINE_HASH(entry) ((entry)[0] | (uint16_t)(entry)[1] << 8)
+#define CACHED_LINE_TEXT_SIZE(entry) ((entry)[2])
+#define CACHED_LINE_BYTECODE_SIZE(entry) ((entry)[3] | (uint16_t)(entry)[4] << 8)
+#define CACHED_LINE_TEXT(entry) ((entry) + CACHED_LINE_HEADER_SIZE)
+#define CACHED_LINE_BYTECODE(entry)                                            \
+    (CACHED_LINE_TEXT(entry) + CACHED_LINE_TEXT_SIZE(entry))
+#define CACHED_LINE_SIZE(entry)                                                \
+    (CACHED_LINE_HEADER_SIZE + CACHED_LINE_TEXT_SIZE(entry)                    \
+     + CACHED_LINE_BYTECODE_SIZE(entry))
+
+// The hash and size of the text in the edit buffer, taken by
+// loadCachedBytecode() for saveCachedBytecode().
+static uint16_t bytecode_cache_hash      = 0;
+static uint8_t  bytecode_cache_text_size = 0;
+
+// Loads the bytecode of the line in the edit buffer into program memory from
+// the cache, making it the most recently run entry.
+// Returns whether it was in the cache. If not, saveCachedBytecode() can add it
+// once it is compiled.
+// edit_buffer (global) - the line.
+// compiler_write_pointer (global) - left on the OPCODE_HALT, like the compiler
+// does.
+static bool loadCachedBytecode(void) {
+    uint8_t* const cache_end = bytecode_cache + bytecode_cache_size;
+    uint8_t*       entry     = bytecode_cache;
+    uint16_t       hash      = 0;
+    uint8_t        size      = 0;
+
+    for (; '\0' != edit_buffer[size]; ++size) {
+        hash = (hash << 1 | hash >> 15) ^ edit_buffer[size];
+    }
+    bytecode_cache_hash      = hash;
+    bytecode_cache_text_size = size;
+
+    for (; entry < cache_end; entry += CACHED_LINE_SIZE(entry)) {
+        if (CACHED_LINE_HASH(entry) == hash
+            && CACHED_LINE_TEXT_SIZE(entry) == size
+            && 0 == memcmp(CACHED_LINE_TEXT(entry), edit_buffer, size)) {
+            break;
+        }
+    }
+    if (entry >= cache_end) return false;
+
+    memcpy(
+        program_memory,
+        CACHED_LINE_BYTECODE(entry),
+        CACHED_LINE_BYTECODE_SIZE(entry)
+    );
+    compiler_write_pointer =
+        program_memory + CACHED_LINE_BYTECODE_SIZE(entry) - 1;
+
+    // Rotates the entry to the front.
+    // The end is found first, since reversing scrambles the header.
+    if (entry != bytecode_cache) {
+        uint8_t* const entry_end = entry + CACHED_LINE_SIZE(entry);
+
+        reverseBytes(bytecode_cache, entry);
+        reverseBytes(entry, entry_end);
+        reverseBytes(bytecode_cache, entry_end);
+    }
+
+    return true;
+}
+
+// Adds the compiled bytecode in program memory to the front of the cache, for
+// the line last given to loadCachedBytecode(), dropping the least recently run
+// entries to make room. Lines too big for the cache aren't added.
+// program_memory (global) - the bytecode.
+// compiler_write_pointer (global) - the OPCODE_HALT at the end of the bytecode.
+static void saveCachedBytecode(void) {
+    const uint16_t bytecode_size =
+        (uint16_t)(compiler_write_pointer - program_memory) + 1;
+    const uint16_t entry_size    =
+        CACHED_LINE_HEADER_SIZE + bytecode_cache_text_size + bytecode_size;
+    uint8_t*       entry         = bytecode_cache;
+
+    if ((uint16_t)(CACHED_LINE_HEADER_SIZE + bytecode_cache_text_size)
+            > BYTECODE_CACHE_SIZE
+            || bytecode_size > BYTECODE_CACHE_SIZE - CACHED_LINE_HEADER_SIZE
+            - bytecode_cache_text_size) {
+        return;
+    }
+
+    // Finds the entries that still fit after the new one. The sizes are
+    // subtracted rather than added, so a big cache can't wrap around.
+    while (entry < bytecode_cache + bytecode_cache_size
+            && (uint16_t)CACHED_LINE_SIZE(entry) <= BYTECODE_CACHE_SIZE
+            - entry_size - (uint16_t)(entry - bytecode_cache)) {
+        entry += CACHED_LINE_SIZE(entry);
+    }
+    bytecode_cache_size = (uint16_t)(entry - bytecode_cache);
+
+    memmove(bytecode_cache + entry_size, bytecode_cache, bytecode_cache_size);
+    bytecode_cache_size += entry_size;
+
+    bytecode_cache[0] = (uint8_t)bytecode_cache_hash;
+    bytecode_cache[1] = (uint8_t)(bytecode_cache_hash >> 8);
+    bytecode_cache[2] = bytecode_cache_text_size;
+    bytecode_cache[3] = (uint8_t)bytecode_size;
+    bytecode_cache[4] = (uint8_t)(bytecode_size >> 8);
+    memcpy(CACHED_LINE_TEXT(bytecode_cache), edit_buffer,
+           bytecode_cache_text_size);
+    memcpy(CACHED_LINE_BYTECODE(bytecode_cache), program_memory, bytecode_size);
+}
+
+#ifdef NATIVE_CODE
+////////////////////////////////////////////////////////////////////////////////
+// Native Code Generator                                                      //
+////////////////////////////////////////////////////////////////////////////////
+
+// 6502 instructions used by the native code generator.
+#define MOS6502_ADC_IMMEDIATE  0x69
+#define MOS6502_ADC_ZERO_PAGE  0x65
+#define MOS6502_ASL_A          0x0A
+#define MOS6502_BCC            0x90
+#define MOS6502_BCS            0xB0
+#define MOS6502_BEQ            0xF0
+#define MOS6502_BNE            0xD0
+#define MOS6502_CLC            0x18
+#define MOS6502_CMP_ABSOLUTE   0xCD
+#define MOS6502_CMP_IMMEDIATE  0xC9
+#define MOS6502_DEC_ZERO_PAGE  0xC6
+#define MOS6502_INC_ZERO_PAGE  0xE6
+#define MOS6502_JMP_ABSOLUTE   0x4C
+#define MOS6502_JSR            0x20
+#define MOS6502_LDA_IMMEDIATE  0xA9
+#define MOS6502_LDA_ZERO_PAGE  0xA5
+#define MOS6502_LDA_INDIRECT_Y 0xB1
+#define MOS6502_LDX_IMMEDIATE  0xA2
+#define MOS6502_LDY_IMMEDIATE  0xA0
+#define MOS6502_RTS            0x60
+#define MOS6502_SBC_IMMEDIATE  0xE9
+#define MOS6502_SBC_ZERO_PAGE  0xE5
+#define MOS6502_SEC            0x38
+#define MOS6502_STA_ZERO_PAGE  0x85
+#define MOS6502_STA_INDIRECT_Y 0x91
+#define MOS6502_TAY            0xA8
+#define MOS6502_TYA            0x98
+
+// Memory for the machine code generated from the bytecode in program memory.
+static uint8_t native_memory[NATIVE_MEMORY_SIZE] = {0};
+// The size of the largest chunk of machine code generated for a single opcode.
+#define NATIVE_MAX_OPCODE_SIZE 64
+
+// Whether to run programs as native code, instead of with the interpreter.
+#ifdef PROFILER
+static bool native_enabled = false;
+#else // PROFILER
+static bool native_enabled = true;
+#endif
+
+// The zero page address of the BASICfuck memory pointer used by native code,
+// followed by the computer memory pointer, a byte of scratch space, and the
+// countdown until STOP is next checked for. This
+// borrows cc65's register variable bank, since any C code called from native
+// code will preserve it.
+// Must call initializeNative() once prior to use.
+static uint8_t native_zero_page = 0;
+#define NATIVE_BFMEM_POINTER (((cell_t**)native_zero_page)[0])
+#define NATIVE_CMEM_POINTER  (((uint8_t**)native_zero_page)[1])
+
+// A one-time-call function used to initialize native_zero_page.
+static void initializeNative(void) {
+    __asm__ volatile ("lda #<regbank");
+    __asm__ volatile ("sta %v", native_zero_page);
+}
+
+// Subroutines called from native code. The Y register must be reset to 0 after
+// calling any of them.
+
+// Prints the given character.
+static void __fastcall__ nativePrint(const uint8_t character) {
+    outputCharacter(character);
+}
+
+// Prints the string of the given OPCODE_PRINT_STRING instruction.
+static void __fastcall__ nativePrintString(const opcode_t* instruction) {
+    const opcode_t* string_pointer = GET_JUMP_TARGET(instruction);
+    uint8_t         count          = instruction[3];
+
+    for (; count > 0; --count) outputCharacter(*(string_pointer++));
+}
+
+// Awaits a key from the type-ahead buffer. Prints an abort message if the key
+// was STOP.
+static uint8_t nativeInput(void) {
+    const uint8_t key = typeAheadGet();
+    if (KEYBOARD_STOP == key) {
+        puts("?ABORT");
+    }
+    return key;
+}
+
+// Returns whether the cell the given distance to the right of the one native
+// code is on is inside of BASICfuck memory, clearing the memory needed to move
+// there if it is.
+static bool __fastcall__ nativeCheckRight(const uint8_t distance) {
+    const cell_t *const target = NATIVE_BFMEM_POINTER + distance;
+
+    if (target >= basicfuck_memory_end) return false;
+    tapeClean(target);
+    return true;
+}
+
+// Moves the cell pointer of native code to the right, clearing the memory
+// needed to do so, or stays put if that would leave BASICfuck memory.
+// Returns whether it moved.
+static bool __fastcall__ nativeMoveRight(const uint8_t distance) {
+    if (!nativeCheckRight(distance)) return false;
+    NATIVE_BFMEM_POINTER += distance;
+    return true;
+}
+
+// Prints the message for an instruction that would move outside of BASICfuck
+// memory.
+static void nativeOutOfBounds(void) {
+    puts("?OUT OF BOUNDS");
+}
+
+// Runs the BASICfuck execute instruction with the pointers held by native code.
+// Returns false, without running it, if the next two cells, which the registers
+// are also taken from, are outside of BASICfuck memory.
+static bool nativeExecute(void) {
+    cell_t* bfmem_pointer = NATIVE_BFMEM_POINTER;
+
+    if (bfmem_pointer + 2 >= basicfuck_memory_end) return false;
+    interpreter_cmem_pointer = NATIVE_CMEM_POINTER;
+    interpreter_register_a   = *bfmem_pointer;
+    interpreter_register_x   = bfmem_pointer[1];
+    interpreter_register_y   = bfmem_pointer[2];
+    basicfuckExecute();
+    // The subroutine may have printed.
+    outputSync();
+    *bfmem_pointer   = interpreter_register_a;
+    bfmem_pointer[1] = interpreter_register_x;
+    bfmem_pointer[2] = interpreter_register_y;
+    return true;
+}
+
+// Native code generator state.
+// Pointer to the current position in native memory.
+static uint8_t* native_write_pointer = NULL;
+// Index into compiler_loop_stack, which holds the locations of the unpatched
+// jump addresses emitted for each currently open loop.
+static uint8_t native_loop_stack_index = 0;
+
+static void __fastcall__ emitNative(const uint8_t byte) {
+    *(native_write_pointer++) = byte;
+}
+
+static void __fastcall__ emitNativeWord(const uint16_t word) {
+    *(uint16_t*)native_write_pointer = word;
+    native_write_pointer += 2;
+}
+
+// Emits a branch instruction with a placeholder offset, which must later be set
+// to branch to the current location with patchNativeBranch().
+// Returns the location of the offset.
+static uint8_t* __fastcall__ emitNativeBranch(const uint8_t instruction) {
+    emitNative(instruction);
+    emitNative(0xFF);
+    return native_write_pointer - 1;
+}
+
+static void __fastcall__ patchNativeBranch(uint8_t *const offset_pointer) {
+    *offset_pointer = native_write_pointer - offset_pointer - 1;
+}
+
+// Emits a branch instruction to the given, previously emitted, location.
+static void emitNativeBranchBack(
+    const uint8_t        instruction,
+    const uint8_t *const target
+) {
+    emitNative(instruction);
+    emitNative(target - native_write_pointer - 1);
+}
+
+// Emits a 16-bit comparison of the zero page pointer at the given address with
+// the given value. The carry flag will be set if the pointer is greater than or
+// equal to the value.
+static void emitNativePointerCompare(
+    const uint8_t  zero_page,
+    const uint16_t value
+) {
+    emitNative(MOS6502_LDA_ZERO_PAGE);
+    emitNative(zero_page);
+    emitNative(MOS6502_CMP_IMMEDIATE);
+    emitNative((uint8_t)value);
+    emitNative(MOS6502_LDA_ZERO_PAGE);
+    emitNative(zero_page + 1);
+    emitNative(MOS6502_SBC_IMMEDIATE);
+    emitNative(value >> 8);
+}
+
+// Emits a stop of the program, for when it would leave BASICfuck memory.
+// JSR nativeOutOfBounds; RTS
+static void emitNativeOutOfBounds(void) {
+    emitNative(MOS6502_JSR);
+    emitNativeWord((uint16_t)&nativeOutOfBounds);
+    emitNative(MOS6502_RTS);
+}
+
+// Emits a check that the cell at the given signed offset from the current one
+// is inside of BASICfuck memory, stopping the program if it isn't.
+static void __fastcall__ emitNativeOffsetCheck(const int8_t offset) {
+    const uint8_t bfmem_pointer = native_zero_page;
+
+    if (offset >= 0) {
+        emitNativePointerCompare(
+            bfmem_pointer, (uint16_t)(basicfuck_memory_end - offset));
+        emitNative(MOS6502_BCC);
+    } else {
+        emitNativePointerCompare(
+            bfmem_pointer, (uint16_t)(basicfuck_memory - offset));
+        emitNative(MOS6502_BCS);
+    }
+    emitNative(4);
+    emitNativeOutOfBounds();
+}
+
+// Emits code to point the Y register at the cell at the given signed offset
+// from the current one. Cells to the left are reached with a Y offset from a
+// pointer 256 bytes before the current one. Must be undone with
+// emitNativeOffsetLeave() before the pointer is otherwise used.
+static void __fastcall__ emitNativeOffsetEnter(const int8_t offset) {
+    if (offset < 0) {
+        emitNative(MOS6502_DEC_ZERO_PAGE);
+        emitNative(native_zero_page + 1);
+    }
+    emitNative(MOS6502_LDY_IMMEDIATE);
+    emitNative((uint8_t)offset);
+}
+
+// Undoes emitNativeOffsetEnter(), leaving the Y register at 0.
+static void __fastcall__ emitNativeOffsetLeave(const int8_t offset) {
+    if (offset < 0) {
+        emitNative(MOS6502_INC_ZERO_PAGE);
+        emitNative(native_zero_page + 1);
+    }
+    emitNative(MOS6502_LDY_IMMEDIATE);
+    emitNative(0);
+}
+
+// Emits a multiplication of the A register by a constant factor, using the
+// given zero page location as scratch space. Factors are multiplied as a series
+// of shifts and adds, one for each bit.
+static void emitNativeMultiply(const uint8_t factor, const uint8_t scratch) {
+    uint8_t bit = 0x80;
+
+    if (1 == factor) return;
+
+    emitNative(MOS6502_STA_ZERO_PAGE);
+    emitNative(scratch);
+    // The highest set bit is the initial value of A.
+    while (0 == (factor & bit)) bit >>= 1;
+    for (bit >>= 1; 0 != bit; bit >>= 1) {
+        emitNative(MOS6502_ASL_A);
+        if (0 != (factor & bit)) {
+            emitNative(MOS6502_CLC);
+            emitNative(MOS6502_ADC_ZERO_PAGE);
+            emitNative(scratch);
+        }
+    }
+}
+
+// Compiles the bytecode in program memory into 6502 machine code in native
+// memory.
+// The generated code keeps the BASICfuck memory pointer and the computer memory
+// pointer in the zero page (see native_zero_page,) and the Y register at 0 for
+// indexing them.
+// Returns true if succeeded, false if ran out of native memory.
+static bool compileNative(void) {
+    const opcode_t* read_pointer   = program_memory;
+    opcode_t        opcode         = 0;
+    uint8_t         argument       = 0;
+    uint16_t        limit          = 0;
+    uint8_t*        patch_pointer  = NULL;
+    uint8_t         factor         = 0;
+    uint8_t*        branch_offset  = NULL;
+    uint8_t*        clamp_offset   = NULL;
+    uint8_t*        loop_pointer   = NULL;
+    const uint8_t   bfmem_pointer  = native_zero_page;
+    const uint8_t   cmem_pointer   = native_zero_page + 2;
+    const uint8_t   scratch        = native_zero_page + 4;
+    const uint8_t   poll_countdown = native_zero_page + 5;
+
+    native_write_pointer    = native_memory;
+    native_loop_stack_index = 0;
+
+    emitNative(MOS6502_LDY_IMMEDIATE);
+    emitNative(0);
+
+    while (true) {
+        if (native_write_pointer + NATIVE_MAX_OPCODE_SIZE
+                > native_memory + NATIVE_MEMORY_SIZE) {
+            return false;
+        }
+
+        opcode   = *read_pointer;
+        argument = read_pointer[1];
+
+        switch (opcode) {
+        case OPCODE_HALT: {
+            emitNative(MOS6502_RTS);
+            return true;
+        }
+
+        // LDA (bfmem),Y; CLC; ADC #argument; STA (bfmem),Y
+        case OPCODE_INCREMENT: {
+            emitNative(MOS6502_LDA_INDIRECT_Y);
+            emitNative(bfmem_pointer);
+            emitNative(MOS6502_CLC);
+            emitNative(MOS6502_ADC_IMMEDIATE);
+            emitNative(argument);
+            emitNative(MOS6502_STA_INDIRECT_Y);
+            emitNative(bfmem_pointer);
+            break;
+        }
+
+        // LDA (bfmem),Y; SEC; SBC #argument; STA (bfmem),Y
+        case OPCODE_DECREMENT: {
+            emitNative(MOS6502_LDA_INDIRECT_Y);
+            emitNative(bfmem_pointer);
+            emitNative(MOS6502_SEC);
+            emitNative(MOS6502_SBC_IMMEDIATE);
+            emitNative(argument);
+            emitNative(MOS6502_STA_INDIRECT_Y);
+            emitNative(bfmem_pointer);
+            break;
+        }
+
+        // Moves to the left, or stops the program if that would leave
+        // BASICfuck memory.
+        case OPCODE_BFMEM_LEFT: {
+            limit = (uint16_t)(basicfuck_memory + argument);
+            // if (bfmem >= limit) goto move; stop;
+            emitNativePointerCompare(bfmem_pointer, limit);
+            emitNative(MOS6502_BCS);
+            emitNative(4);
+            emitNativeOutOfBounds();
+            // move: bfmem -= argument; (carry is already set.)
+            emitNative(MOS6502_LDA_ZERO_PAGE);
+            emitNative(bfmem_pointer);
+            emitNative(MOS6502_SBC_IMMEDIATE);
+            emitNative(argument);
+            emitNative(MOS6502_STA_ZERO_PAGE);
+            emitNative(bfmem_pointer);
+            emitNative(MOS6502_BCS);
+            emitNative(2);
+            emitNative(MOS6502_DEC_ZERO_PAGE);
+            emitNative(bfmem_pointer + 1);
+            // done:
+            break;
+        }
+
+        // Moves to the right, leaving it to nativeMoveRight() if that could
+        // pass tape_move_end, which clears more memory, or stops the program
+        // if that would leave BASICfuck memory.
+        case OPCODE_BFMEM_RIGHT: {
+            // if (bfmem >= tape_move_page * 256) goto slow;
+            emitNative(MOS6502_LDA_ZERO_PAGE);
+            emitNative(bfmem_pointer + 1);
+            emitNative(MOS6502_CMP_ABSOLUTE);
+            emitNativeWord((uint16_t)&tape_move_page);
+            branch_offset = emitNativeBranch(MOS6502_BCS);
+            // bfmem += argument; goto done; (carry is already clear.)
+            emitNative(MOS6502_LDA_ZERO_PAGE);
+            emitNative(bfmem_pointer);
+            emitNative(MOS6502_ADC_IMMEDIATE);
+            emitNative(argument);
+            emitNative(MOS6502_STA_ZERO_PAGE);
+            emitNative(bfmem_pointer);
+            clamp_offset  = emitNativeBranch(MOS6502_BCC);
+            emitNative(MOS6502_INC_ZERO_PAGE);
+            emitNative(bfmem_pointer + 1);
+            // BASICfuck memory is never in the zero page, so this always
+            // branches.
+            loop_pointer  = emitNativeBranch(MOS6502_BNE);
+            // slow: if (nativeMoveRight(argument)) goto done; stop;
+            patchNativeBranch(branch_offset);
+            emitNative(MOS6502_LDA_IMMEDIATE);
+            emitNative(argument);
+            emitNative(MOS6502_JSR);
+            emitNativeWord((uint16_t)&nativeMoveRight);
+            emitNative(MOS6502_LDY_IMMEDIATE);
+            emitNative(0);
+            emitNative(MOS6502_CMP_IMMEDIATE);
+            emitNative(0);
+            emitNative(MOS6502_BNE);
+            emitNative(4);
+            emitNativeOutOfBounds();
+            // done:
+            patchNativeBranch(clamp_offset);
+            patchNativeBranch(loop_pointer);
+            break;
+        }
+
+        // LDA (bfmem),Y; BEQ done; if (bfmem < basicfuck_memory + argument1)
+        // goto stop; if (bfmem < tape_move_page * 256) goto done;
+        // if (nativeCheckRight(argument2)) goto done;
+        // stop: JSR nativeOutOfBounds; RTS; done:
+        case OPCODE_CHECK_BOUNDS: {
+            emitNative(MOS6502_LDA_INDIRECT_Y);
+            emitNative(bfmem_pointer);
+            branch_offset = emitNativeBranch(MOS6502_BEQ);
+            emitNativePointerCompare(
+                bfmem_pointer, (uint16_t)(basicfuck_memory + argument));
+            clamp_offset  = emitNativeBranch(MOS6502_BCC);
+            emitNative(MOS6502_LDA_ZERO_PAGE);
+            emitNative(bfmem_pointer + 1);
+            emitNative(MOS6502_CMP_ABSOLUTE);
+            emitNativeWord((uint16_t)&tape_move_page);
+            loop_pointer  = emitNativeBranch(MOS6502_BCC);
+            emitNative(MOS6502_LDA_IMMEDIATE);
+            emitNative(read_pointer[2]);
+            emitNative(MOS6502_JSR);
+            emitNativeWord((uint16_t)&nativeCheckRight);
+            emitNative(MOS6502_LDY_IMMEDIATE);
+            emitNative(0);
+            emitNative(MOS6502_CMP_IMMEDIATE);
+            emitNative(0);
+            emitNative(MOS6502_BNE);
+            emitNative(4);
+            patchNativeBranch(clamp_offset);
+            emitNativeOutOfBounds();
+            patchNativeBranch(branch_offset);
+            patchNativeBranch(loop_pointer);
+            break;
+        }
+
+        // LDA bfmem; SEC; SBC #argument; STA bfmem; BCS +2; DEC bfmem+1
+        case OPCODE_BFMEM_LEFT_UNCHECKED: {
+            emitNative(MOS6502_LDA_ZERO_PAGE);
+            emitNative(bfmem_pointer);
+            emitNative(MOS6502_SEC);
+            emitNative(MOS6502_SBC_IMMEDIATE);
+            emitNative(argument);
+            emitNative(MOS6502_STA_ZERO_PAGE);
+            emitNative(bfmem_pointer);
+            emitNative(MOS6502_BCS);
+            emitNative(2);
+            emitNative(MOS6502_DEC_ZERO_PAGE);
+            emitNative(bfmem_pointer + 1);
+            break;
+        }
+
+        // LDA bfmem; CLC; ADC #argument; STA bfmem; BCC +2; INC bfmem+1
+        case OPCODE_BFMEM_RIGHT_UNCHECKED: {
+            emitNative(MOS6502_LDA_ZERO_PAGE);
+            emitNative(bfmem_pointer);
+            emitNative(MOS6502_CLC);
+            emitNative(MOS6502_ADC_IMMEDIATE);
+            emitNative(argument);
+            emitNative(MOS6502_STA_ZERO_PAGE);
+            emitNative(bfmem_pointer);
+            emitNative(MOS6502_BCC);
+            emitNative(2);
+            emitNative(MOS6502_INC_ZERO_PAGE);
+            emitNative(bfmem_pointer + 1);
+            break;
+        }
+
+        // LDA (bfmem),Y; JSR nativePrint; LDY #0
+        case OPCODE_PRINT: {
+            emitNative(MOS6502_LDA_INDIRECT_Y);
+            emitNative(bfmem_pointer);
+            emitNative(MOS6502_JSR);
+            emitNativeWord((uint16_t)&nativePrint);
+            emitNative(MOS6502_LDY_IMMEDIATE);
+            emitNative(0);
+            break;
+        }
+
+        // LDA #<instruction; LDX #>instruction; JSR nativePrintString; LDY #0
+        case OPCODE_PRINT_STRING: {
+            emitNative(MOS6502_LDA_IMMEDIATE);
+            emitNative((uint8_t)(uint16_t)read_pointer);
+            emitNative(MOS6502_LDX_IMMEDIATE);
+            emitNative((uint8_t)((uint16_t)read_pointer >> 8));
+            emitNative(MOS6502_JSR);
+            emitNativeWord((uint16_t)&nativePrintString);
+            emitNative(MOS6502_LDY_IMMEDIATE);
+            emitNative(0);
+            break;
+        }
+
+        // JSR nativeInput; CMP #KEYBOARD_STOP; BNE +1; RTS; LDY #0;
+        // STA (bfmem),Y
+        case OPCODE_INPUT: {
+            emitNative(MOS6502_JSR);
+            emitNativeWord((uint16_t)&nativeInput);
+            emitNative(MOS6502_CMP_IMMEDIATE);
+            emitNative(KEYBOARD_STOP);
+            emitNative(MOS6502_BNE);
+            emitNative(1);
+            emitNative(MOS6502_RTS);
+            emitNative(MOS6502_LDY_IMMEDIATE);
+            emitNative(0);
+            emitNative(MOS6502_STA_INDIRECT_Y);
+            emitNative(bfmem_pointer);
+            break;
+        }
+
+        // LDA (bfmem),Y; BNE +3; JMP <end of loop>
+        // The jump address is patched once the end of the loop is reached.
+        case OPCODE_JEQ:
+        case OPCODE_JEQ_SHORT: {
+            assert(native_loop_stack_index < MAX_LOOP_DEPTH && "unreachable");
+
+            emitNative(MOS6502_LDA_INDIRECT_Y);
+            emitNative(bfmem_pointer);
+            emitNative(MOS6502_BNE);
+            emitNative(3);
+            emitNative(MOS6502_JMP_ABSOLUTE);
+            compiler_loop_stack[native_loop_stack_index++] = native_write_pointer;
+            emitNativeWord(0xFFFF);
+            break;
+        }
+
+        // LDA (bfmem),Y; BEQ +14; DEC countdown; BNE +7; JSR pollStop; TAY;
+        // BEQ +1; RTS; JMP <start of loop body>
+        // Checking for STOP only when looping back, once every 256 times, keeps
+        // it off of the path of most instructions.
+        case OPCODE_JNE:
+        case OPCODE_JNE_SHORT: {
+            assert(native_loop_stack_index > 0 && "unreachable");
+            patch_pointer = compiler_loop_stack[--native_loop_stack_index];
+
+            emitNative(MOS6502_LDA_INDIRECT_Y);
+            emitNative(bfmem_pointer);
+            emitNative(MOS6502_BEQ);
+            emitNative(14);
+            emitNative(MOS6502_DEC_ZERO_PAGE);
+            emitNative(poll_countdown);
+            emitNative(MOS6502_BNE);
+            emitNative(7);
+            emitNative(MOS6502_JSR);
+            emitNativeWord((uint16_t)&pollStop);
+            emitNative(MOS6502_TAY);
+            emitNative(MOS6502_BEQ);
+            emitNative(1);
+            emitNative(MOS6502_RTS);
+            emitNative(MOS6502_JMP_ABSOLUTE);
+            emitNativeWord((uint16_t)(patch_pointer + 2));
+
+            *(uint16_t*)patch_pointer = (uint16_t)native_write_pointer;
+            break;
+        }
+
+        // LDA (cmem),Y; STA (bfmem),Y
+        case OPCODE_CMEM_READ: {
+            emitNative(MOS6502_LDA_INDIRECT_Y);
+            emitNative(cmem_pointer);
+            emitNative(MOS6502_STA_INDIRECT_Y);
+            emitNative(bfmem_pointer);
+            break;
+        }
+
+        // LDA (bfmem),Y; STA (cmem),Y
+        case OPCODE_CMEM_WRITE: {
+            emitNative(MOS6502_LDA_INDIRECT_Y);
+            emitNative(bfmem_pointer);
+            emitNative(MOS6502_STA_INDIRECT_Y);
+            emitNative(cmem_pointer);
+            break;
+        }
+
+        // Subtracts from the computer memory pointer, stopping at 0.
+        case OPCODE_CMEM_LEFT: {
+            // cmem -= argument; if (no borrow) goto done;
+            emitNative(MOS6502_LDA_ZERO_PAGE);
+            emitNative(cmem_pointer);
+            emitNative(MOS6502_SEC);
+            emitNative(MOS6502_SBC_IMMEDIATE);
+            emitNative(argument);
+            emitNative(MOS6502_STA_ZERO_PAGE);
+            emitNative(cmem_pointer);
+            emitNative(MOS6502_BCS);
+            emitNative(12);
+            // if (0 == high byte) goto clamp;
+            emitNative(MOS6502_LDA_ZERO_PAGE);
+            emitNative(cmem_pointer + 1);
+            emitNative(MOS6502_BEQ);
+            emitNative(4);
+            // --high byte; goto done; (carry is still clear.)
+            emitNative(MOS6502_DEC_ZERO_PAGE);
+            emitNative(cmem_pointer + 1);
+            emitNative(MOS6502_BCC);
+            emitNative(4);
+            // clamp: cmem = 0;
+            emitNative(MOS6502_LDA_IMMEDIATE);
+            emitNative(0);
+            emitNative(MOS6502_STA_ZERO_PAGE);
+            emitNative(cmem_pointer);
+            // done:
+            break;
+        }
+
+        // Adds to the computer memory pointer, stopping at $FFFF.
+        case OPCODE_CMEM_RIGHT: {
+            // cmem += argument; if (no carry) goto done;
+            emitNative(MOS6502_LDA_ZERO_PAGE);
+            emitNative(cmem_pointer);
+            emitNative(MOS6502_CLC);
+            emitNative(MOS6502_ADC_IMMEDIATE);
+            emitNative(argument);
+            emitNative(MOS6502_STA_ZERO_PAGE);
+            emitNative(cmem_pointer);
+            emitNative(MOS6502_BCC);
+            emitNative(10);
+            // if (0 != ++high byte) goto done;
+            emitNative(MOS6502_INC_ZERO_PAGE);
+            emitNative(cmem_pointer + 1);
+            emitNative(MOS6502_BNE);
+            emitNative(6);
+            // cmem = 0xFFFF;
+            emitNative(MOS6502_LDA_IMMEDIATE);
+            emitNative(0xFF);
+            emitNative(MOS6502_STA_ZERO_PAGE);
+            emitNative(cmem_pointer);
+            emitNative(MOS6502_STA_ZERO_PAGE);
+            emitNative(cmem_pointer + 1);
+            // done:
+            break;
+        }
+
+        // if (nativeExecute()) goto done; stop;
+        case OPCODE_EXECUTE: {
+            emitNative(MOS6502_JSR);
+            emitNativeWord((uint16_t)&nativeExecute);
+            emitNative(MOS6502_LDY_IMMEDIATE);
+            emitNative(0);
+            emitNative(MOS6502_CMP_IMMEDIATE);
+            emitNative(0);
+            emitNative(MOS6502_BNE);
+            emitNative(4);
+            emitNativeOutOfBounds();
+            // done:
+            break;
+        }
+
+        // TYA; STA (bfmem),Y
+        case OPCODE_SET_ZERO: {
+            emitNative(MOS6502_TYA);
+            emitNative(MOS6502_STA_INDIRECT_Y);
+            emitNative(bfmem_pointer);
+            break;
+        }
+
+        case OPCODE_MULTIPLY_ADD: {
+            // Skips everything if the current cell is 0, since the loop this
+            // replaced wouldn't run, and so couldn't leave BASICfuck memory.
+            emitNative(MOS6502_LDA_INDIRECT_Y);
+            emitNative(bfmem_pointer);
+            branch_offset = emitNativeBranch(MOS6502_BEQ);
+            emitNativeOffsetCheck((int8_t)argument);
+
+            // Factors over 128 are handled by subtracting the product of their
+            // negation, which takes fewer instructions.
+            factor = read_pointer[2];
+            emitNative(MOS6502_LDA_INDIRECT_Y);
+            emitNative(bfmem_pointer);
+            emitNativeMultiply(factor > 128 ? -factor : factor, scratch);
+            emitNative(MOS6502_STA_ZERO_PAGE);
+            emitNative(scratch);
+
+            emitNativeOffsetEnter((int8_t)argument);
+            emitNative(MOS6502_LDA_INDIRECT_Y);
+            emitNative(bfmem_pointer);
+            if (factor > 128) {
+                emitNative(MOS6502_SEC);
+                emitNative(MOS6502_SBC_ZERO_PAGE);
+            } else {
+                emitNative(MOS6502_CLC);
+                emitNative(MOS6502_ADC_ZERO_PAGE);
             }
-            goto lfinish_interpreter_cycle;
-        }
+            emitNative(scratch);
+            emitNative(MOS6502_STA_INDIRECT_Y);
+            emitNative(bfmem_pointer);
+            emitNativeOffsetLeave((int8_t)argument);
 
-lopcode_jne: {
-            if (0 != *interpreter_bfmem_pointer) {
-                interpreter_program_pointer =
-                    *(opcode_t**)(interpreter_program_pointer + 1);
-            }
-            goto lfinish_interpreter_cycle;
+            patchNativeBranch(branch_offset);
+            break;
         }
 
-lopcode_cmem_read: {
-            *interpreter_bfmem_pointer = *interpreter_cmem_pointer;
-            goto lfinish_interpreter_cycle;
+        // LDA (bfmem),Y; CLC; ADC #argument2; STA (bfmem),Y, at the offset.
+        case OPCODE_ADD_AT: {
+            emitNativeOffsetCheck((int8_t)argument);
+            emitNativeOffsetEnter((int8_t)argument);
+            emitNative(MOS6502_LDA_INDIRECT_Y);
+            emitNative(bfmem_pointer);
+            emitNative(MOS6502_CLC);
+            emitNative(MOS6502_ADC_IMMEDIATE);
+            emitNative(read_pointer[2]);
+            emitNative(MOS6502_STA_INDIRECT_Y);
+            emitNative(bfmem_pointer);
+            emitNativeOffsetLeave((int8_t)argument);
+            break;
         }
 
-lopcode_cmem_write: {
-            *interpreter_cmem_pointer = *interpreter_bfmem_pointer;
-            goto lfinish_interpreter_cycle;
+        // LDA (bfmem),Y, at the offset; JSR nativePrint; LDY #0
+        case OPCODE_PRINT_AT: {
+            emitNativeOffsetCheck((int8_t)argument);
+            emitNativeOffsetEnter((int8_t)argument);
+            emitNative(MOS6502_LDA_INDIRECT_Y);
+            emitNative(bfmem_pointer);
+            emitNativeOffsetLeave((int8_t)argument);
+            emitNative(MOS6502_JSR);
+            emitNativeWord((uint16_t)&nativePrint);
+            emitNative(MOS6502_LDY_IMMEDIATE);
+            emitNative(0);
+            break;
         }
 
-lopcode_cmem_left: {
-            if ((uint16_t)interpreter_cmem_pointer > argument) {
-                interpreter_cmem_pointer -= argument;
-            } else {
-                interpreter_cmem_pointer = 0;
-            }
-            goto lfinish_interpreter_cycle;
+        // LDA #0; STA (bfmem),Y, at the offset.
+        case OPCODE_SET_ZERO_AT: {
+            emitNativeOffsetCheck((int8_t)argument);
+            emitNativeOffsetEnter((int8_t)argument);
+            emitNative(MOS6502_LDA_IMMEDIATE);
+            emitNative(0);
+            emitNative(MOS6502_STA_INDIRECT_Y);
+            emitNative(bfmem_pointer);
+            emitNativeOffsetLeave((int8_t)argument);
+            break;
         }
 
-lopcode_cmem_right: {
-            if (UINT16_MAX - (uint16_t)interpreter_cmem_pointer > argument) {
-                interpreter_cmem_pointer += argument;
-            } else {
-                interpreter_cmem_pointer = (uint8_t*)UINT16_MAX;
-            }
-            goto lfinish_interpreter_cycle;
+        // If a scan would leave BASICfuck memory on a cell that isn't 0, the
+        // program is stopped.
+        case OPCODE_SCAN_LEFT: {
+            limit = (uint16_t)(basicfuck_memory + argument);
+            // loop: if (0 == *bfmem) goto done;
+            loop_pointer  = native_write_pointer;
+            emitNative(MOS6502_LDA_INDIRECT_Y);
+            emitNative(bfmem_pointer);
+            branch_offset = emitNativeBranch(MOS6502_BEQ);
+            // if (bfmem < limit) goto stop;
+            emitNativePointerCompare(bfmem_pointer, limit);
+            clamp_offset  = emitNativeBranch(MOS6502_BCC);
+            // bfmem -= argument; goto loop; (carry is already set.)
+            emitNative(MOS6502_LDA_ZERO_PAGE);
+            emitNative(bfmem_pointer);
+            emitNative(MOS6502_SBC_IMMEDIATE);
+            emitNative(argument);
+            emitNative(MOS6502_STA_ZERO_PAGE);
+            emitNative(bfmem_pointer);
+            emitNativeBranchBack(MOS6502_BCS, loop_pointer);
+            emitNative(MOS6502_DEC_ZERO_PAGE);
+            emitNative(bfmem_pointer + 1);
+            emitNativeBranchBack(MOS6502_BCC, loop_pointer);
+            // stop:
+            patchNativeBranch(clamp_offset);
+            emitNativeOutOfBounds();
+            // done:
+            patchNativeBranch(branch_offset);
+            break;
         }
 
-lopcode_execute: {
-            interpreter_register_a = *interpreter_bfmem_pointer;
-            interpreter_register_x = interpreter_bfmem_pointer[1];
-            interpreter_register_y = interpreter_bfmem_pointer[2];
-            basicfuckExecute();
-            *interpreter_bfmem_pointer   = interpreter_register_a;
-            interpreter_bfmem_pointer[1] = interpreter_register_x;
-            interpreter_bfmem_pointer[2] = interpreter_register_y;
-            goto lfinish_interpreter_cycle;
+        case OPCODE_SCAN_RIGHT: {
+            // loop: if (0 == *bfmem) goto done;
+            loop_pointer  = native_write_pointer;
+            emitNative(MOS6502_LDA_INDIRECT_Y);
+            emitNative(bfmem_pointer);
+            branch_offset = emitNativeBranch(MOS6502_BEQ);
+            // if (bfmem >= tape_move_page * 256) goto slow;
+            emitNative(MOS6502_LDA_ZERO_PAGE);
+            emitNative(bfmem_pointer + 1);
+            emitNative(MOS6502_CMP_ABSOLUTE);
+            emitNativeWord((uint16_t)&tape_move_page);
+            clamp_offset  = emitNativeBranch(MOS6502_BCS);
+            // bfmem += argument; goto loop; (carry is already clear.)
+            emitNative(MOS6502_LDA_ZERO_PAGE);
+            emitNative(bfmem_pointer);
+            emitNative(MOS6502_ADC_IMMEDIATE);
+            emitNative(argument);
+            emitNative(MOS6502_STA_ZERO_PAGE);
+            emitNative(bfmem_pointer);
+            emitNativeBranchBack(MOS6502_BCC, loop_pointer);
+            emitNative(MOS6502_INC_ZERO_PAGE);
+            emitNative(bfmem_pointer + 1);
+            emitNativeBranchBack(MOS6502_BCS, loop_pointer);
+            // slow: if (nativeMoveRight(argument)) goto loop; stop;
+            patchNativeBranch(clamp_offset);
+            emitNative(MOS6502_LDA_IMMEDIATE);
+            emitNative(argument);
+            emitNative(MOS6502_JSR);
+            emitNativeWord((uint16_t)&nativeMoveRight);
+            emitNative(MOS6502_LDY_IMMEDIATE);
+            emitNative(0);
+            emitNative(MOS6502_CMP_IMMEDIATE);
+            emitNative(0);
+            emitNativeBranchBack(MOS6502_BNE, loop_pointer);
+            // stop:
+            emitNativeOutOfBounds();
+            // done:
+            patchNativeBranch(branch_offset);
+            break;
         }
 
-lfinish_interpreter_cycle: {
-            // Jumped to after an opcode has been executed.
-            interpreter_program_pointer += opcode_size_table[opcode];
+        default:
+            assert(false && "unreachable");
         }
+
+        read_pointer += opcode_size_table[opcode];
     }
 }
 
+// Runs the native code compiled from the last program.
+// interpreter_bfmem_pointer (global) - the current BASICfuck memory pointer.
+// interpreter_cmem_pointer (global) - the current computer memory pointer.
+static void runNative(void) {
+    static uint8_t saved_zero_page[6] = {0};
+
+    // Anything the C code calling this had in the borrowed zero page locations
+    // must be put back afterwards.
+    memcpy(saved_zero_page, (uint8_t*)native_zero_page, sizeof(saved_zero_page));
+    NATIVE_BFMEM_POINTER = interpreter_bfmem_pointer;
+    NATIVE_CMEM_POINTER  = interpreter_cmem_pointer;
+    ((uint8_t*)native_zero_page)[5] = 0;
+
+    __asm__ volatile ("jsr %v", native_memory);
+
+    interpreter_bfmem_pointer = NATIVE_BFMEM_POINTER;
+    interpreter_cmem_pointer  = NATIVE_CMEM_POINTER;
+    memcpy((uint8_t*)native_zero_page, saved_zero_page, sizeof(saved_zero_page));
+}
+#endif // NATIVE_CODE
+
+#ifdef ASSEMBLY_INTERPRETER
+////////////////////////////////////////////////////////////////////////////////
+// Assembly Interpreter                                                       //
+////////////////////////////////////////////////////////////////////////////////
+
+// Parameters for the interpreter in baf-interpreter.s. The layout must match
+// the offsets given there.
+typedef struct {
+    const opcode_t* program;
+    const cell_t*   bfmem_start;
+    const cell_t*   bfmem_end;
+    const cell_t*   bfmem_move_end;
+    void (*print)(const uint8_t character);
+    uint8_t (*input)(void);
+    bool (*poll_stop)(void);
+    bool (*execute)(void);
+    void (*out_of_bounds)(void);
+    const cell_t* (*clean)(const cell_t* target);
+    uint8_t stop_key;
+} assembly_interpreter_parameters_t;
+
+// The memory pointers are filled in by interpret().
+static assembly_interpreter_parameters_t assembly_interpreter_parameters = {
+    program_memory,
+    NULL,
+    NULL,
+    NULL,
+    &nativePrint,
+    &nativeInput,
+    &pollStop,
+    &nativeExecute,
+    &nativeOutOfBounds,
+    &tapeClean,
+    KEYBOARD_STOP
+};
+
+// Defined in baf-interpreter.s.
+// Expects the BASICfuck memory pointer and the computer memory pointer in the
+// same zero page locations as native code.
+void __fastcall__ interpretAssembly(
+    const assembly_interpreter_parameters_t* parameters);
+
+// Runs the interpreter with the given bytecode-compiled BASICfuck program.
+// interpreter_bfmem_pointer (global) - the current BASICfuck memory pointer.
+// interpreter_cmem_pointer (global) - the current computer memory pointer.
+static void interpret(void) {
+    // The assembly interpreter also keeps its program pointer after the ones
+    // shared with native code.
+    static uint8_t saved_zero_page[6] = {0};
+
+    memcpy(saved_zero_page, (uint8_t*)native_zero_page, sizeof(saved_zero_page));
+    NATIVE_BFMEM_POINTER = interpreter_bfmem_pointer;
+    NATIVE_CMEM_POINTER  = interpreter_cmem_pointer;
+    assembly_interpreter_parameters.bfmem_start    = basicfuck_memory;
+    assembly_interpreter_parameters.bfmem_end      = basicfuck_memory_end;
+    assembly_interpreter_parameters.bfmem_move_end = tape_move_end;
+
+    interpretAssembly(&assembly_interpreter_parameters);
+
+    interpreter_bfmem_pointer = NATIVE_BFMEM_POINTER;
+    interpreter_cmem_pointer  = NATIVE_CMEM_POINTER;
+    memcpy((uint8_t*)native_zero_page, saved_zero_page, sizeof(saved_zero_page));
+}
+#endif // ASSEMBLY_INTERPRETER
+
 ////////////////////////////////////////////////////////////////////////////////
 // REPL                                                                       //
 ////////////////////////////////////////////////////////////////////////////////
@@ -914,7 +4304,36 @@ static void helpMenu(void) {
         "? - Displays this help menu.\n"
         "L - Displays license.\n"
         "# - Displays bytecode of last program.\n"
+        "F<file> - Runs program from file.\n"
+        "LIST - Lists stored program.\n"
+        "RUN - Runs stored program.\n"
+        "NEW - Clears stored program.\n"
+        "CLR - Clears BASICfuck memory.\n"
+        "SAVE<file> - Saves memory to file.\n"
+        "LOAD<file> - Loads memory from file.\n"
+#ifdef REU
+        "STASH/FETCH - Copy memory to/from REU.\n"
+#endif
+#ifdef PROFILER
+        "P - Displays profile of last program.\n"
+#endif
+#ifdef NATIVE_CODE
+        "$ - Toggles native code compilation.\n"
+#endif
+#ifdef __CC65__
+        "S - Toggles fast screen output.\n"
+#endif
+        "\n"
+        "Lines starting with a number are stored, replacing any line with that "
+        "number, or deleting it if nothing follows, to be run in order of "
+        "number with RUN.\n"
         "\n"
+        "Press ANY KEY to CONTINUE"
+    );
+    wrappedCgetc();
+
+    clrscr();
+    puts(
         "REPL Controls (Keypress):\n"
         "\n"
         KEYBOARD_STOP_STRING
@@ -1021,29 +4440,439 @@ static void utoaFputs(
     const uint16_t value,
     const uint8_t radix
 ) {
-    static uint8_t string_buffer[SCREEN_BUFFER_SIZE] = {0};
+    static char    string_buffer[SCREEN_BUFFER_SIZE] = {0};
     size_t         leading_zeros = 0;
 
     utoa(value, string_buffer, radix);
 
     if (0 != digit_count) {
         leading_zeros = digit_count - strlen(string_buffer);
-        for (; leading_zeros > 0; --leading_zeros) fputs("0", stdout);
+        for (; leading_zeros > 0; --leading_zeros) outputCharacter('0');
     }
 
-    fputs(string_buffer, stdout);
+    outputString(string_buffer);
 };
 
+#ifdef BANKED_TAPE
+// Like utoaFputs(), but for 32-bit values in decimal, which BANKED_TAPE
+// positions can need. Values longer than digit_count are printed in full.
+static void ultoaFputs(const uint8_t digit_count, const unsigned long value) {
+    static char string_buffer[11] = {0};
+    uint8_t     i                 = 0;
+
+    ultoa(value, string_buffer, 10);
+    for (i = (uint8_t)strlen(string_buffer); i < digit_count; ++i) {
+        outputCharacter('0');
+    }
+    outputString(string_buffer);
+}
+#endif
+
+// Sets BASICfuck memory to 0, and moves both pointers back to the start, like
+// when the REPL starts. Without BANKED_TAPE, only the cells that have been
+// cleared before are, since the rest are cleared when first reached.
+// interpreter_bfmem_pointer, interpreter_cmem_pointer (global) - the pointers.
+// prefix_memory_zero (global) - set.
+static void clearMemory(void) {
+#ifdef BANKED_TAPE
+    tapeSeek(0);
+    tapeClearBanks();
+    clearCells(basicfuck_memory, BASICFUCK_MEMORY_SIZE * sizeof(cell_t));
+#else // BANKED_TAPE
+    // The cells past tape_clean_end haven't been touched since being cleared.
+    clearCells(basicfuck_memory,
+               (uint16_t)(tape_clean_end - basicfuck_memory) * sizeof(cell_t));
+#endif
+
+    interpreter_bfmem_pointer = basicfuck_memory;
+    interpreter_cmem_pointer  = CMEM_POINTER(0);
+    prefix_memory_zero        = true;
+}
+
+#ifdef REU
+// The pointers when the snapshot was taken.
+#ifdef BANKED_TAPE
+static tape_position_t reu_snapshot_cell = 0;
+#else // BANKED_TAPE
+static uint16_t        reu_snapshot_cell = 0;
+#endif
+static uint8_t*        reu_snapshot_cmem = NULL;
+#ifndef BANKED_TAPE
+// The number of cells that had been cleared, which are the only ones stashed.
+static uint16_t        reu_snapshot_size = 0;
+#endif
+
+// Copies BASICfuck memory in main memory, and the pointers, into the REU. With
+// BANKED_TAPE, the banks already are in the REU, and are left as they are.
+// interpreter_bfmem_pointer, interpreter_cmem_pointer (global) - the pointers.
+static void stashMemory(void) {
+    if (!reu_present) {
+        puts("?NO REU");
+        return;
+    }
+
+#ifdef BANKED_TAPE
+    reu_snapshot_cell = tapePosition();
+    reuTransfer(
+        REU_STASH, tape_main_memory, reu_snapshot_address, REU_SNAPSHOT_SIZE, 0
+    );
+#else // BANKED_TAPE
+    reu_snapshot_cell =
+        (uint16_t)(interpreter_bfmem_pointer - basicfuck_memory);
+    reu_snapshot_size = (uint16_t)(tape_clean_end - basicfuck_memory);
+    reuTransfer(
+        REU_STASH, basicfuck_memory, reu_snapshot_address,
+        reu_snapshot_size * sizeof(cell_t), 0
+    );
+#endif
+    reu_snapshot_cmem  = interpreter_cmem_pointer;
+    reu_snapshot_taken = true;
+}
+
+// Copies what stashMemory() saved back.
+// interpreter_bfmem_pointer, interpreter_cmem_pointer (global) - the pointers.
+// prefix_memory_zero (global) - cleared.
+static void fetchMemory(void) {
+    if (!reu_present) {
+        puts("?NO REU");
+        return;
+    }
+    if (!reu_snapshot_taken) {
+        puts("?NOTHING STASHED");
+        return;
+    }
+
+#ifdef BANKED_TAPE
+    reuTransfer(
+        REU_FETCH, tape_main_memory, reu_snapshot_address, REU_SNAPSHOT_SIZE, 0
+    );
+    tapeSeek(reu_snapshot_cell);
+#else // BANKED_TAPE
+    reuTransfer(
+        REU_FETCH, basicfuck_memory, reu_snapshot_address,
+        reu_snapshot_size * sizeof(cell_t), 0
+    );
+    // Anything past what was stashed was touched after it was.
+    tapeMarkClean(reu_snapshot_size);
+    interpreter_bfmem_pointer = basicfuck_memory + reu_snapshot_cell;
+#endif
+    interpreter_cmem_pointer = reu_snapshot_cmem;
+    prefix_memory_zero       = false;
+}
+#endif // REU
+
+// Snapshots are files holding what running programs leaves behind, so it can be
+// picked back up after the REPL is restarted. Only the cells from the first to
+// the last that aren't 0 are kept. Numbers are little-endian, and the file is
+// laid out as follows:
+// - SNAPSHOT_MAGIC, which includes the version of the format.
+// - 1 byte - the size of a cell, in bytes.
+// - 4 bytes - the position of the current cell.
+// - 2 bytes - the computer memory address.
+// - 4 bytes - the position of the first cell kept.
+// - 4 bytes - the number of cells kept.
+// - 2 bytes - the size of the bytecode.
+// - the cells kept.
+// - the bytecode of the last program, followed by the strings printed by its
+//   OPCODE_PRINT_STRING instructions, in order.
+#define SNAPSHOT_MAGIC       "BAF\x01"
+#define SNAPSHOT_HEADER_SIZE 21
+#ifdef BANKED_TAPE
+#  define SNAPSHOT_TAPE_SIZE tape_size
+#  define SNAPSHOT_USED_SIZE tape_size
+#else // BANKED_TAPE
+#  define SNAPSHOT_TAPE_SIZE BASICFUCK_MEMORY_SIZE
+// The cells past tape_clean_end haven't been touched.
+#  define SNAPSHOT_USED_SIZE (uint16_t)(tape_clean_end - basicfuck_memory)
+#endif
+
+static uint8_t snapshot_header[SNAPSHOT_HEADER_SIZE] = {0};
+
+static void __fastcall__ putSnapshotLong(
+    uint8_t *const      pointer,
+    const unsigned long value
+) {
+    pointer[0] = (uint8_t)value;
+    pointer[1] = (uint8_t)(value >> 8);
+    pointer[2] = (uint8_t)(value >> 16);
+    pointer[3] = (uint8_t)(value >> 24);
+}
+
+static unsigned long __fastcall__ getSnapshotLong(const uint8_t *const pointer) {
+    return pointer[0] | (uint16_t)pointer[1] << 8
+           | (unsigned long)pointer[2] << 16 | (unsigned long)pointer[3] << 24;
+}
+
+// Returns the position of the current cell in BASICfuck memory.
+static unsigned long snapshotPosition(void) {
+#ifdef BANKED_TAPE
+    return tapePosition();
+#else // BANKED_TAPE
+    return (uint16_t)(interpreter_bfmem_pointer - basicfuck_memory);
+#endif
+}
+
+// Moves the cell pointer to the given position in BASICfuck memory.
+// Returns the number of cells from there that can be accessed directly.
+static uint16_t snapshotSeek(const unsigned long position) {
+#ifdef BANKED_TAPE
+    tapeSeek(position);
+#else // BANKED_TAPE
+    interpreter_bfmem_pointer = basicfuck_memory + (uint16_t)position;
+#endif
+    return (uint16_t)(basicfuck_memory_end - interpreter_bfmem_pointer);
+}
+
+// Reads, or writes, the given number of bytes of the file, in pieces small
+// enough for read() and write() to count.
+// Returns false if they couldn't all be.
+static bool transferSnapshot(
+    const int  file,
+    void*      buffer,
+    uint16_t   size,
+    const bool writing
+) {
+    uint8_t* pointer = buffer;
+    int      count   = 0;
+
+    while (0 != size) {
+        count = size > 0x4000 ? 0x4000 : size;
+        count = writing ? write(file, pointer, count)
+                : read(file, pointer, count);
+        if (count <= 0) return false;
+        pointer += count;
+        size    -= count;
+    }
+    return true;
+}
+
+// Reads, or writes, the given span of BASICfuck memory, a window at a time,
+// leaving the cell pointer somewhere in it.
+// Returns false if it couldn't all be.
+static bool transferSnapshotCells(
+    const int     file,
+    unsigned long position,
+    unsigned long count,
+    const bool    writing
+) {
+    uint16_t size = 0;
+
+    while (0 != count) {
+        size = snapshotSeek(position);
+        if (size > count) size = (uint16_t)count;
+        if (!transferSnapshot(file, interpreter_bfmem_pointer,
+                              size * sizeof(cell_t), writing)) {
+            return false;
+        }
+        position += size;
+        count    -= size;
+    }
+    return true;
+}
+
+// Returns the size of the bytecode of the last program, including the strings
+// after it, or 0 if it isn't a whole program.
+// program_memory (global) - the bytecode.
+static uint16_t snapshotBytecodeSize(void) {
+    const opcode_t* instruction = program_memory;
+    uint16_t        size        = 1;
+
+    while (OPCODE_HALT != *instruction) {
+        if (*instruction >= ARRAY_SIZE(opcode_size_table)) return 0;
+        if (OPCODE_PRINT_STRING == *instruction) size += instruction[3];
+        instruction += opcode_size_table[*instruction];
+        if (instruction >= program_memory + PROGRAM_MEMORY_SIZE) return 0;
+    }
+    return size + (uint16_t)(instruction - program_memory);
+}
+
+// Saves a snapshot to the file named after the command at the start of the edit
+// buffer.
+// edit_buffer (global) - the command with the file name.
+// interpreter_bfmem_pointer, interpreter_cmem_pointer (global) - the pointers.
+// program_memory (global) - the bytecode.
+static void saveSnapshot(void) {
+    const char*         file_name     = commandFileName(4);
+    const unsigned long position      = snapshotPosition();
+    const uint16_t      bytecode_size = snapshotBytecodeSize();
+    unsigned long       first         = SNAPSHOT_TAPE_SIZE;
+    unsigned long       last          = 0;
+    unsigned long       start         = 0;
+    uint16_t            size          = 0;
+    uint16_t            i             = 0;
+    int                 file          = -1;
+    bool                success       = false;
+
+    if (NULL == file_name) return;
+
+    for (; start < SNAPSHOT_USED_SIZE; start += size) {
+        size = snapshotSeek(start);
+        if (size > SNAPSHOT_USED_SIZE - start) {
+            size = (uint16_t)(SNAPSHOT_USED_SIZE - start);
+        }
+        for (i = 0; i < size; ++i) {
+            if (0 == interpreter_bfmem_pointer[i]) continue;
+            if (first == SNAPSHOT_TAPE_SIZE) first = start + i;
+            last = start + i;
+        }
+    }
+    if (first == SNAPSHOT_TAPE_SIZE) first = last + 1;
+
+    memcpy(snapshot_header, SNAPSHOT_MAGIC, 4);
+    snapshot_header[4] = sizeof(cell_t);
+    putSnapshotLong(snapshot_header + 5, position);
+    snapshot_header[9]  = (uint8_t)CMEM_ADDRESS(interpreter_cmem_pointer);
+    snapshot_header[10] = (uint8_t)(CMEM_ADDRESS(interpreter_cmem_pointer) >> 8);
+    putSnapshotLong(snapshot_header + 11, first);
+    putSnapshotLong(snapshot_header + 15, last + 1 - first);
+    snapshot_header[19] = (uint8_t)bytecode_size;
+    snapshot_header[20] = (uint8_t)(bytecode_size >> 8);
+
+    file = open(file_name, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (file < 0) {
+        puts("?CANNOT OPEN FILE");
+        snapshotSeek(position);
+        return;
+    }
+    success = transferSnapshot(file, snapshot_header, SNAPSHOT_HEADER_SIZE, true)
+              && transferSnapshotCells(file, first, last + 1 - first, true)
+              && transferSnapshot(file, program_memory, bytecode_size, true);
+    if (0 != close(file)) success = false;
+    snapshotSeek(position);
+
+    if (!success) puts("?CANNOT WRITE FILE");
+}
+
+// Loads a snapshot from the file named after the command at the start of the
+// edit buffer, replacing all of BASICfuck memory. If the snapshot can't be read
+// after that starts, BASICfuck memory is left cleared.
+// edit_buffer (global) - the command with the file name.
+// interpreter_bfmem_pointer, interpreter_cmem_pointer (global) - set.
+// program_memory, compiler_write_pointer (global) - set to the bytecode.
+// prefix_memory_zero (global) - cleared.
+static void loadSnapshot(void) {
+    const char*     file_name      = commandFileName(4);
+    opcode_t*       string_pointer = NULL;
+    opcode_t*       instruction    = NULL;
+    unsigned long   position       = 0;
+    unsigned long   first          = 0;
+    unsigned long   count          = 0;
+    uint16_t        bytecode_size  = 0;
+    int             file           = -1;
+
+    if (NULL == file_name) return;
+
+    file = open(file_name, O_RDONLY);
+    if (file < 0) {
+        puts("?CANNOT OPEN FILE");
+        return;
+    }
+    if (!transferSnapshot(file, snapshot_header, SNAPSHOT_HEADER_SIZE, false)) {
+        puts("?CANNOT READ FILE");
+        goto lclose;
+    }
+
+    position      = getSnapshotLong(snapshot_header + 5);
+    first         = getSnapshotLong(snapshot_header + 11);
+    count         = getSnapshotLong(snapshot_header + 15);
+    bytecode_size = snapshot_header[19] | (uint16_t)snapshot_header[20] << 8;
+    if (0 != memcmp(snapshot_header, SNAPSHOT_MAGIC, 4)
+            || sizeof(cell_t) != snapshot_header[4]
+            || position >= SNAPSHOT_TAPE_SIZE
+            || first > SNAPSHOT_TAPE_SIZE
+            || count > SNAPSHOT_TAPE_SIZE - first
+            || bytecode_size > PROGRAM_MEMORY_SIZE) {
+        puts("?NOT A SNAPSHOT");
+        goto lclose;
+    }
+
+    clearMemory();
+    prefix_memory_zero = false;
+#ifndef BANKED_TAPE
+    tapeClean(basicfuck_memory + first + count);
+    tapeClean(basicfuck_memory + position);
+#endif
+    if (!transferSnapshotCells(file, first, count, false)
+            || !transferSnapshot(file, program_memory, bytecode_size, false)) {
+        clearMemory();
+        program_memory[0]      = OPCODE_HALT;
+        compiler_write_pointer = program_memory;
+        puts("?CANNOT READ FILE");
+        goto lclose;
+    }
+    snapshotSeek(position);
+    interpreter_cmem_pointer = CMEM_POINTER(
+        snapshot_header[9] | (uint16_t)snapshot_header[10] << 8
+    );
+
+    // Relinks the bytecode, which may have been saved by a different build.
+    // Anything that isn't a whole program is thrown out.
+    if (0 == bytecode_size || snapshotBytecodeSize() != bytecode_size
+            || NULL != compileSecondPass()) {
+        program_memory[0]      = OPCODE_HALT;
+        compiler_write_pointer = program_memory;
+        goto lclose;
+    }
+    string_pointer = compiler_write_pointer + 1;
+    for (instruction = program_memory; OPCODE_HALT != *instruction;
+            instruction += opcode_size_table[*instruction]) {
+        if (OPCODE_PRINT_STRING != *instruction) continue;
+        SET_JUMP_TARGET(instruction, string_pointer);
+        string_pointer += instruction[3];
+    }
+
+lclose:
+    close(file);
+}
+
+// Prints the lines in the program store.
+// program_store, program_store_size (global) - the program store.
+static void listProgram(void) {
+    const uint8_t* line = program_store;
+    uint8_t        i    = 0;
+
+    outputSync();
+
+    for (; line < program_store + program_store_size;
+            line += STORED_LINE_SIZE(line)) {
+        // Slow down while holding space.
+        if (kbhit() != 0 && cgetc() == ' ')
+            sleep(1);
+
+        utoaFputs(0, STORED_LINE_NUMBER(line), 10);
+        outputCharacter(' ');
+        for (i = 0; i < STORED_LINE_TEXT_SIZE(line); ++i) {
+            outputCharacter(STORED_LINE_TEXT(line)[i]);
+        }
+        outputCharacter('\n');
+    }
+}
+
+// Prints the address of the given offset into program memory, with a leading
+// '$' (no newline.)
+static void programAddressFputs(const uint16_t offset) {
+    outputCharacter('$');
+#ifdef __CC65__
+    utoaFputs(4, (uint16_t)program_memory + offset, 16);
+#else // __CC65__
+    // Host addresses don't fit, so offsets are shown like in jumps.
+    utoaFputs(4, offset, 16);
+#endif
+}
+
 // Displays a readout of the bytecode of the last program to the user.
 // Holding space will slow down the printing.
 // program_memory (global) - the program buffer.
+// compiler_write_pointer (global) - the end of the last compiled program.
 static void displayBytecode(void) {
-    uint8_t i = 0;
+    uint16_t i = 0;
 
     // Ideally display 16 bytes at a time, but screen real estate is what it is.
     uint8_t bytes_per_line = (width - 7) / 3;
     bytes_per_line = bytes_per_line > 16 ? 16 : bytes_per_line;
 
+    outputSync();
+
     while (true) {
         if (i % bytes_per_line == 0) {
             // Slow down while holding space.
@@ -1051,30 +4880,259 @@ static void displayBytecode(void) {
                 sleep(1);
 
             // Prints addresses.
-            fputs("\n$", stdout);
-            utoaFputs(4, (uint16_t)program_memory + i, 16);
-            putchar(':');
+            outputCharacter('\n');
+            programAddressFputs(i);
+            outputCharacter(':');
         }
         // Prints values.
-        putchar(' ');
+        outputCharacter(' ');
         utoaFputs(2, program_memory[i], 16);
 
-        if (i >= PROGRAM_MEMORY_SIZE - 1) break;
+        // Only the last program is shown, since the rest of program memory can
+        // be quite large.
+        if (program_memory + i >= compiler_write_pointer
+            || i >= PROGRAM_MEMORY_SIZE - 1) {
+            break;
+        }
         ++i;
     }
 
-    putchar('\n');
+    outputCharacter('\n');
+}
+
+#ifdef PROFILER
+// Displays the bytecode of the last program to the user, one instruction per
+// line, with how many times each was run. Instructions that ran at least half
+// as often as the most run one are marked with a '*', and the loop whose body
+// ran the most is shown at the end.
+// Holding space will slow down the printing.
+// program_memory (global) - the program buffer.
+// compiler_write_pointer (global) - the end of the last compiled program.
+// profiler_counts (global) - the number of times each instruction was run.
+static void displayProfile(void) {
+    const opcode_t* instruction  = program_memory;
+    const opcode_t* hottest_loop = NULL;
+    uint16_t        offset       = 0;
+    uint16_t        count        = 0;
+    uint16_t        most_count   = 0;
+    uint8_t         i            = 0;
+
+    for (; instruction <= compiler_write_pointer;
+            instruction += opcode_size_table[*instruction]) {
+        count = profiler_counts[instruction - program_memory];
+        if (count > most_count) most_count = count;
+
+        // A loop's end runs once each time its body does.
+        if ((OPCODE_JNE == *instruction || OPCODE_JNE_SHORT == *instruction)
+                && (NULL == hottest_loop
+                || count > profiler_counts[hottest_loop - program_memory])) {
+            hottest_loop = instruction;
+        }
+    }
+
+    outputSync();
+    for (instruction = program_memory; instruction <= compiler_write_pointer;
+            instruction += opcode_size_table[*instruction]) {
+        // Slow down while holding space.
+        if (kbhit() != 0 && cgetc() == ' ')
+            sleep(1);
+
+        offset = instruction - program_memory;
+        count  = profiler_counts[offset];
+
+        programAddressFputs(offset);
+        outputCharacter(':');
+        for (i = 0; i < MAX_OPCODE_SIZE; ++i) {
+            if (i < opcode_size_table[*instruction]) {
+                outputCharacter(' ');
+                utoaFputs(2, instruction[i], 16);
+            } else {
+                outputString("   ");
+            }
+        }
+        outputCharacter(' ');
+        utoaFputs(5, count, 10);
+        if (0 != count && count >= most_count - most_count / 2) outputCharacter('*');
+        outputCharacter('\n');
+    }
+
+    if (NULL != hottest_loop
+            && 0 != profiler_counts[hottest_loop - program_memory]) {
+        outputString("HOTTEST LOOP ");
+        programAddressFputs((OPCODE_JNE_SHORT == *hottest_loop
+                             ? hottest_loop + (int8_t)hottest_loop[1]
+                             : GET_JUMP_TARGET(hottest_loop)) - program_memory);
+        outputCharacter('-');
+        programAddressFputs(hottest_loop - program_memory);
+        outputString(" RAN ");
+        utoaFputs(0, profiler_counts[hottest_loop - program_memory], 10);
+        outputString(" TIMES\n");
+    }
+    if (UINT16_MAX == most_count) outputString("(COUNTS STOP AT 65535)\n");
+}
+#endif // PROFILER
+
+// Compiles and runs the program in the edit buffer, or in the source file if
+// one was opened, closing it afterwards, or in the program store if
+// compiler_use_program_store is set, clearing it afterwards. Programs from the
+// edit buffer that were run recently are taken from the bytecode cache instead
+// of being compiled again. If BASICfuck memory is all 0, the start of the
+// program is run while compiling it.
+// Returns false, after printing an error message, if it couldn't be compiled.
+// edit_buffer (global) - the program to run.
+static bool evaluate(void) {
+    const char* error_message = NULL;
+    // Only lines typed in are cached, since files and the program store can
+    // change without their text in the edit buffer changing.
+    const bool  cacheable     = !compiler_use_program_store
+                                && -1 == compiler_source_file;
+
+    if (cacheable && loadCachedBytecode()) goto lrun;
+
+    error_message = compiler_use_program_store ? compileProgramStore()
+                    : compileFirstPass();
+    // Only the first pass reads the source.
+    closeSourceFile();
+    compiler_use_program_store = false;
+    if (NULL != error_message) {
+        puts(error_message);
+        return false;
+    }
+    error_message = compileSecondPass();
+    if (NULL != error_message) {
+        puts(error_message);
+        return false;
+    }
+    compileIdiomPass();
+    compileOffsetPass();
+#ifndef BANKED_TAPE
+    compileBoundsPass();
+#endif
+    compileJumpPass();
+    if (cacheable) saveCachedBytecode();
+
+lrun:
+    // Done after caching, since it depends on BASICfuck memory.
+    compilePrefixPass();
+    outputSync();
+    typeAheadBegin();
+#ifdef NATIVE_CODE
+    // Falls back to the interpreter if the program is too big to compile.
+    if (native_enabled && compileNative()) {
+        runNative();
+    } else {
+        interpret();
+    }
+#else // NATIVE_CODE
+    interpret();
+#endif
+    typeAheadEnd();
+    prefix_memory_zero = false;
+
+    return true;
+}
+
+#ifdef BENCHMARK
+////////////////////////////////////////////////////////////////////////////////
+// Benchmark                                                                  //
+////////////////////////////////////////////////////////////////////////////////
+
+// Generated by build.sh. Defines BENCHMARK_PROGRAM as the program to run.
+#include "benchmark.h"
+
+// The benchmark emulators point the first disk drive (or H: device) at a
+// directory on the host computer, where build.sh picks the results up.
+#ifdef __ATARI__
+#define BENCHMARK_RESULTS_FILE "H:BENCH.TXT"
+#else // __ATARI__
+#define BENCHMARK_RESULTS_FILE "bench.txt"
+#endif
+
+// Runs BENCHMARK_PROGRAM and writes how many clock ticks it took, followed by
+// the number of clock ticks per second, to BENCHMARK_RESULTS_FILE. If it
+// couldn't be compiled, "ERROR" is written instead.
+// Compilation is timed along with the run, since both happen whenever a line is
+// evaluated.
+// edit_buffer (global) - where the program is placed to be compiled.
+static void runBenchmark(void) {
+    static char string_buffer[11] = {0};
+    FILE*       results           = NULL;
+    bool        success           = false;
+    clock_t     ticks             = 0;
+
+    strcpy((char*)edit_buffer, BENCHMARK_PROGRAM);
+#ifndef BANKED_TAPE
+    // Clears all of memory up front, so only the program is timed.
+    tapeClean(basicfuck_memory_end);
+#endif
+    ticks   = clock();
+    success = evaluate();
+    ticks   = clock() - ticks;
+
+    results = fopen(BENCHMARK_RESULTS_FILE, "w");
+    if (NULL == results) {
+        puts("?CANNOT WRITE RESULTS");
+        return;
+    }
+    if (success) {
+        fputs(ultoa(ticks, string_buffer, 10), results);
+        fputc(' ', results);
+        fputs(ultoa(CLOCKS_PER_SEC, string_buffer, 10), results);
+    } else {
+        fputs("ERROR", results);
+    }
+    fputc('\n', results);
+    fclose(results);
+
+    puts("BENCHMARK DONE");
 }
+#endif // BENCHMARK
 
 int main(void) {
     // Initializes global screen size variables in screen.h.
     screensize(&width, &height);
     // Initializes the opcode table in basicfuck.h.
     initializeInstructionOpcodeTable();
+#ifdef NATIVE_CODE
+    initializeNative();
+#endif
+    initializeTypeAhead();
+#ifdef REU
+    initializeReu();
+#endif
+#ifdef BANKED_TAPE
+    initializeTape();
+#else // BANKED_TAPE
+    if (!initializeMemory()) {
+        puts("?OUT OF MEMORY");
+#ifdef __CC65__
+        // Says how many cells would fit, to size BASICfuck memory by.
+        outputSync();
+        utoaFputs(0, _heapmaxavail() / sizeof(cell_t), 10);
+        puts(" CELLS FREE");
+#endif
+        deinitializeTypeAhead();
+        return 1;
+    }
+#endif
+
+#ifdef BENCHMARK
+    runBenchmark();
+#ifdef BANKED_TAPE
+    deinitializeTape();
+#endif
+    deinitializeTypeAhead();
+    return 0;
+#endif
 
     clrscr();
     puts("BASICfuck REPL 0.2.0\n");
+    outputSync();
+#ifdef BANKED_TAPE
+    ultoaFputs(0, tape_size);
+#else // BANKED_TAPE
     utoaFputs(0, BASICFUCK_MEMORY_SIZE, 10);
+#endif
     puts(
         " CELLS FREE\n"
         "\n"
@@ -1101,42 +5159,123 @@ int main(void) {
             continue;
         }
         case 'L': {
-            licenseMenu();
+            if (0 == strcmp((const char*)edit_buffer, "LIST")) {
+                listProgram();
+            } else if (0 == strncmp((const char*)edit_buffer, "LOAD", 4)) {
+                loadSnapshot();
+            } else {
+                licenseMenu();
+            }
             continue;
         }
+        case 'R': {
+            // Anything else is just a BASICfuck program starting with a
+            // comment.
+            if (0 == strcmp((const char*)edit_buffer, "RUN")) {
+                compiler_use_program_store = true;
+            }
+            break;
+        }
+        case 'N': {
+            if (0 == strcmp((const char*)edit_buffer, "NEW")) {
+                program_store_size = 0;
+                continue;
+            }
+            break;
+        }
+        case 'C': {
+            if (0 == strcmp((const char*)edit_buffer, "CLR")) {
+                clearMemory();
+                continue;
+            }
+            break;
+        }
         case '#': {
             displayBytecode();
             continue;
         }
-        default: {
+        case 'F': {
+#ifdef REU
+            if (0 == strcmp((const char*)edit_buffer, "FETCH")) {
+                fetchMemory();
+                continue;
+            }
+#endif
+            // Runs the program in the file, like it was typed in.
+            if (!openSourceFile()) continue;
             break;
         }
-        }
-
-        // Evaluate.
-        if (!compileFirstPass()) {
-            puts("?OUT OF MEMORY");
+#ifdef PROFILER
+        case 'P': {
+            displayProfile();
             continue;
         }
-        if (!compileSecondPass()) {
-            puts("?UNTERMINATED LOOP");
+#endif
+#ifdef NATIVE_CODE
+        case '$': {
+            native_enabled = !native_enabled;
+            puts(native_enabled ? "NATIVE CODE ON" : "NATIVE CODE OFF");
             continue;
         }
-        interpret();
+#endif
+        case 'S': {
+            if (0 == strncmp((const char*)edit_buffer, "SAVE", 4)) {
+                saveSnapshot();
+                continue;
+            }
+#ifdef REU
+            if (0 == strcmp((const char*)edit_buffer, "STASH")) {
+                stashMemory();
+                continue;
+            }
+#endif
+#ifdef __CC65__
+            if (0 == strcmp((const char*)edit_buffer, "S")) {
+                fast_output_enabled = !fast_output_enabled;
+                puts(fast_output_enabled ? "FAST OUTPUT ON"
+                                         : "FAST OUTPUT OFF");
+                continue;
+            }
+#endif
+            // Anything else is just a BASICfuck program starting with a
+            // comment.
+            break;
+        }
+        default: {
+            // Numbered lines are stored for RUN instead of being run.
+            if (edit_buffer[0] >= '0' && edit_buffer[0] <= '9') {
+                storeLine();
+                continue;
+            }
+            break;
+        }
+        }
+
+        // Evaluate.
+        if (!evaluate()) continue;
 
         // Print.
-        utoaFputs(3, *interpreter_bfmem_pointer, 10);
-        fputs(" (Cell ", stdout);
+        outputSync();
+        utoaFputs(CELL_DIGITS, *interpreter_bfmem_pointer, 10);
+        outputString(" (Cell ");
+#ifdef BANKED_TAPE
+        ultoaFputs(5, tapePosition());
+#else // BANKED_TAPE
         utoaFputs(
             5,
             (uint16_t)(interpreter_bfmem_pointer - basicfuck_memory)
             , 10
         );
-        fputs(", Memory $", stdout);
-        utoaFputs(4, (uint16_t)interpreter_cmem_pointer, 16);
-        puts(")");
+#endif
+        outputString(", Memory $");
+        utoaFputs(4, CMEM_ADDRESS(interpreter_cmem_pointer), 16);
+        outputString(")\n");
     }
 lexit_repl:
+#ifdef BANKED_TAPE
+    deinitializeTape();
+#endif
+    deinitializeTypeAhead();
 
     return 0;
 }
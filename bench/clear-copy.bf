@@ -0,0 +1,4 @@
+-[>-[>+>+<<-]>>[<<+>>-]<[-]<<-]
+
+Clears and copies cells with loops that compile to the multiply-add and
+set-zero idioms, 255 times 255 over.
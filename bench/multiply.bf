@@ -0,0 +1,5 @@
+-[[>+>+>+<<<-]>>>[<<<+>>>-]<<[>[>+>+<<-]>[<+>-]<<-]>[-]<<-]
+
+Sums the squares of 255 down to 1 by repeated addition, as a stand-in for
+arithmetic heavy programs like Mandelbrot renderers, which are too long to
+fit on a line.
@@ -0,0 +1,3 @@
+++++++++[>++++++++[>++++++++[>++++++++[>++++++++[>++++++++[>+<-]<-]<-]<-]<-]<-]
+
+Six levels of nested counting loops, 32768 runs of the innermost one.
@@ -0,0 +1,4 @@
+++++[>-[->>[>]+[<]<]>>[>]<[-<]<<-]
+
+Grows a row of 255 set cells one at a time, scanning to its end and back
+each time, then clears it. Repeated 4 times.
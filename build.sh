@@ -37,50 +37,200 @@ set -u
 # Sets:
 # - basicfuck_memory_size - the amount of memory, in bytes, to give for
 #   BASICfuck memory.
+# - native_memory_size - the amount of memory, in bytes, to give for natively
+#   compiled BASICfuck programs.
+# - program_memory_size - the amount of memory, in bytes, to give for compiled
+#   BASICfuck bytecode.
+# - program_store_size - the amount of memory, in bytes, to give for the lines
+#   of the program run with RUN.
+# - bytecode_cache_size - the amount of memory, in bytes, to give for the
+#   bytecode of recently run lines.
+# - type_ahead_size - the number of keys the type-ahead buffer holds.
 # - binary_file_extension - the file extension to use for the compiled program.
 # - emulator - the emulator command to use. Append the program file to this
 #   command.
+# - bench_emulator - the emulator command to use for benchmarking. Append the
+#   program file to this command. Empty if the target can't be benchmarked.
+# - cpu_frequency - the clock speed, in hertz, of the target's CPU.
 load_config_for_target() {
     if [ c64 = "$1" ]; then
         basicfuck_memory_size=$C64_CELL_MEMORY_SIZE
+        native_memory_size=$C64_NATIVE_MEMORY_SIZE
+        program_memory_size=$C64_PROGRAM_MEMORY_SIZE
+        program_store_size=$C64_PROGRAM_STORE_SIZE
+        bytecode_cache_size=$C64_BYTECODE_CACHE_SIZE
+        type_ahead_size=$C64_TYPE_AHEAD_SIZE
         binary_file_extension=$C64_BINARY_FILE_EXTENSION
         emulator=$C64_EMULATOR
+        bench_emulator=$C64_BENCH_EMULATOR
+        cpu_frequency=$C64_CPU_FREQUENCY
     elif [ c128 = "$1" ]; then
         basicfuck_memory_size=$C128_CELL_MEMORY_SIZE
+        native_memory_size=$C128_NATIVE_MEMORY_SIZE
+        program_memory_size=$C128_PROGRAM_MEMORY_SIZE
+        program_store_size=$C128_PROGRAM_STORE_SIZE
+        bytecode_cache_size=$C128_BYTECODE_CACHE_SIZE
+        type_ahead_size=$C128_TYPE_AHEAD_SIZE
         binary_file_extension=$C128_BINARY_FILE_EXTENSION
         emulator=$C128_EMULATOR
+        bench_emulator=$C128_BENCH_EMULATOR
+        cpu_frequency=$C128_CPU_FREQUENCY
     elif [ plus4 = "$1" ]; then
         basicfuck_memory_size=$PLUS4_CELL_MEMORY_SIZE
+        native_memory_size=$PLUS4_NATIVE_MEMORY_SIZE
+        program_memory_size=$PLUS4_PROGRAM_MEMORY_SIZE
+        program_store_size=$PLUS4_PROGRAM_STORE_SIZE
+        bytecode_cache_size=$PLUS4_BYTECODE_CACHE_SIZE
+        type_ahead_size=$PLUS4_TYPE_AHEAD_SIZE
         binary_file_extension=$PLUS4_BINARY_FILE_EXTENSION
         emulator=$PLUS4_EMULATOR
+        bench_emulator=$PLUS4_BENCH_EMULATOR
+        cpu_frequency=$PLUS4_CPU_FREQUENCY
     elif [ pet = "$1" ]; then
         basicfuck_memory_size=$PET_CELL_MEMORY_SIZE
+        native_memory_size=$PET_NATIVE_MEMORY_SIZE
+        program_memory_size=$PET_PROGRAM_MEMORY_SIZE
+        program_store_size=$PET_PROGRAM_STORE_SIZE
+        bytecode_cache_size=$PET_BYTECODE_CACHE_SIZE
+        type_ahead_size=$PET_TYPE_AHEAD_SIZE
         binary_file_extension=$PET_BINARY_FILE_EXTENSION
         emulator=$PET_EMULATOR
+        bench_emulator=$PET_BENCH_EMULATOR
+        cpu_frequency=$PET_CPU_FREQUENCY
     elif [ cx16 = "$1" ]; then
         basicfuck_memory_size=$CX16_CELL_MEMORY_SIZE
+        native_memory_size=$CX16_NATIVE_MEMORY_SIZE
+        program_memory_size=$CX16_PROGRAM_MEMORY_SIZE
+        program_store_size=$CX16_PROGRAM_STORE_SIZE
+        bytecode_cache_size=$CX16_BYTECODE_CACHE_SIZE
+        type_ahead_size=$CX16_TYPE_AHEAD_SIZE
         binary_file_extension=$CX16_BINARY_FILE_EXTENSION
         emulator=$CX16_EMULATOR
+        bench_emulator=$CX16_BENCH_EMULATOR
+        cpu_frequency=$CX16_CPU_FREQUENCY
     elif [ atari = "$1" ]; then
         basicfuck_memory_size=$ATARI_CELL_MEMORY_SIZE
+        native_memory_size=$ATARI_NATIVE_MEMORY_SIZE
+        program_memory_size=$ATARI_PROGRAM_MEMORY_SIZE
+        program_store_size=$ATARI_PROGRAM_STORE_SIZE
+        bytecode_cache_size=$ATARI_BYTECODE_CACHE_SIZE
+        type_ahead_size=$ATARI_TYPE_AHEAD_SIZE
         binary_file_extension=$ATARI_BINARY_FILE_EXTENSION
         emulator=$ATARI_EMULATOR
+        bench_emulator=$ATARI_BENCH_EMULATOR
+        cpu_frequency=$ATARI_CPU_FREQUENCY
+    elif [ host = "$1" ]; then
+        basicfuck_memory_size=$HOST_CELL_MEMORY_SIZE
+        native_memory_size=$HOST_NATIVE_MEMORY_SIZE
+        program_memory_size=$HOST_PROGRAM_MEMORY_SIZE
+        program_store_size=$HOST_PROGRAM_STORE_SIZE
+        bytecode_cache_size=$HOST_BYTECODE_CACHE_SIZE
+        type_ahead_size=$HOST_TYPE_AHEAD_SIZE
+        binary_file_extension=$HOST_BINARY_FILE_EXTENSION
+        emulator=$HOST_EMULATOR
+        bench_emulator=''
+        cpu_frequency=''
     elif [ atarixl = "$1" ]; then
         basicfuck_memory_size=$ATARIXL_CELL_MEMORY_SIZE
+        native_memory_size=$ATARIXL_NATIVE_MEMORY_SIZE
+        program_memory_size=$ATARIXL_PROGRAM_MEMORY_SIZE
+        program_store_size=$ATARIXL_PROGRAM_STORE_SIZE
+        bytecode_cache_size=$ATARIXL_BYTECODE_CACHE_SIZE
+        type_ahead_size=$ATARIXL_TYPE_AHEAD_SIZE
         binary_file_extension=$ATARIXL_BINARY_FILE_EXTENSION
         emulator=$ATARIXL_EMULATOR
+        bench_emulator=$ATARIXL_BENCH_EMULATOR
+        cpu_frequency=$ATARIXL_CPU_FREQUENCY
     else
         echo "ERROR: No build configuration for target '$1'" 1>&2
         exit 1
     fi
 }
 
+################################################################################
+# Benchmarking                                                                 #
+################################################################################
+
+# Builds the REPL to run a benchmark program instead of itself.
+# $1 - build target.
+# $2 - benchmark program file. Only the first line is used, the rest can
+#   describe the program.
+# $3 - directory to build in.
+build_benchmark() {
+    mkdir -p "$3" || exit 1
+
+    program=$(head -n 1 "$2")
+    # The program is placed in the edit buffer, which only holds a line.
+    if [ 254 -lt ${#program} ]; then
+        echo "ERROR: Benchmark program '$2' is longer than 254 characters" 1>&2
+        exit 1
+    fi
+    printf '#define BENCHMARK_PROGRAM "%s"\n' \
+           "$(printf '%s' "$program" | sed 's/[\\"]/\\&/g')" \
+           > "$3/benchmark.h" || exit 1
+
+    if ! OUT_DIRECTORY="$3" "$0" build "$1" -D BENCHMARK -I "$3" \
+         > "$3/build.log" 2>&1; then
+        cat "$3/build.log" 1>&2
+        echo "ERROR: Failed to build benchmark '$2' for target '$1'" 1>&2
+        exit 1
+    fi
+}
+
+# Runs a benchmark built by build_benchmark in the benchmark emulator, waiting
+# until the results are written to the 'results' subdirectory, or until
+# bench_timeout seconds pass.
+# $1 - build target. Its configuration must be loaded.
+# $2 - directory the benchmark was built in.
+run_benchmark() {
+    binary="$PWD/$2/$1/${repl_source%.c}${binary_file_extension:+.$binary_file_extension}"
+
+    mkdir -p "$2/results" || exit 1
+    (
+        cd "$2/results" || exit 1
+        # shellcheck disable=SC2086 # We want word splitting.
+        $bench_emulator "$binary" > ../emulator.log 2>&1 &
+        emulator_pid=$!
+
+        waited=0
+        while [ "$waited" -lt "$bench_timeout" ]; do
+            # The results are a single line.
+            if [ 0 -lt "$(cat ./* 2> /dev/null | wc -l)" ]; then
+                break
+            fi
+            sleep 1
+            waited=$((waited + 1))
+        done
+
+        kill "$emulator_pid" 2> /dev/null
+        wait "$emulator_pid" 2> /dev/null
+    )
+}
+
+# Prints the results of a benchmark run by run_benchmark, in CPU cycles.
+# $1 - directory the benchmark was built in.
+# $2 - clock speed, in hertz, of the target's CPU.
+print_benchmark_result() {
+    # shellcheck disable=SC2046 # The results are "TICKS TICKS_PER_SECOND".
+    set -- "$2" $(cat "$1"/results/* 2> /dev/null)
+
+    if [ 3 -eq $# ]; then
+        echo $(($2 * $1 / $3))
+    elif [ 2 -eq $# ]; then
+        echo "$2"
+    else
+        echo TIMEOUT
+    fi
+}
+
 ################################################################################
 # Command Line Interface                                                       #
 ################################################################################
 
 targets='c64 c128 pet plus4 cx16 atari atarixl'
 repl_source=baf-repl.c
+interpreter_source=baf-interpreter.s
+host_source=host/conio.c
 
 if [ 0 -eq $# ]; then
     echo "Usages:
@@ -98,18 +248,59 @@ Subcommands:
     Build for the specified target.
     Set the EXTRA_CFLAGS environment variable to add options to cl65.
     Set the CFLAGS environment variable to override the default options to cl65.
+    The 'host' target builds for the computer running this script, using the
+    compiler and options given by the HOST_CC and HOST_CFLAGS environment
+    variables instead.
+    Set the ASSEMBLY_INTERPRETER environment variable to 1 to use the faster
+    interpreter written in assembly instead of the one written in C.
+    Set the PROFILER environment variable to 1 to count how many times each
+    instruction runs, for the REPL's 'P' command. Can't be used with
+    ASSEMBLY_INTERPRETER.
+    Set the CELL_WIDTH environment variable to 16 to use 16-bit BASICfuck cells
+    instead of 8-bit ones (default 8.) 16-bit cells take twice the memory, so
+    there are half as many, and programs always run with the interpreter
+    written in C. Can't be used with ASSEMBLY_INTERPRETER.
+    Set the BANKED_TAPE environment variable to 1 to extend BASICfuck memory
+    into the extended memory of the c128, cx16, and atarixl targets (emulated on
+    the host target.) Ignored for other targets. Programs always run with the
+    interpreter written in C. Can't be used with ASSEMBLY_INTERPRETER.
+    Set the REU environment variable to 1 to use a RAM Expansion Unit on the
+    c64 and c128 targets (emulated on the host target) for the REPL's CLR,
+    STASH, and FETCH commands. Ignored for other targets. With BANKED_TAPE,
+    BASICfuck memory is extended into the REU instead, which also works on the
+    c64 target.
+    Builds for targets other than 'host' also write the linker's map file next
+    to the binary, which shows how much memory the program takes.
 
   run <target>
     Run the configured emulator for the specfied target.
+
+  bench <target> [programs...]
+    Benchmark the specified target (or all of them) by running each program
+    in 'bench/' (or the given program files) headless in the configured
+    benchmark emulator. Reports the CPU cycles each program took to compile and
+    run, measured with the target's clock, and the size of the REPL binary.
+    Set the BENCH_JOBS environment variable to the number of emulators to run
+    at once (default 1.)
+    Set the BENCH_TIMEOUT environment variable to the number of seconds to wait
+    for each program (default 600.)
+    The build subcommand's environment variables apply to the builds.
+
+  test [sessions...]
+    Build the host target and type each REPL session in 'test/' (or the given
+    session files) into it, checking that everything it prints after its banner
+    matches the session's '.expected' file.
+    The build subcommand's environment variables apply to the build.
 "
     exit
 fi
 
 if [ targets = "$1" ]; then
-    echo 'all (for build subcommand only)'
+    echo 'all (for build and bench subcommands only)'
     for target in $targets; do
         echo "$target"
     done
+    echo 'host'
     exit
 fi
 
@@ -129,8 +320,16 @@ if [ build = "$1" ]; then
     # Remaining arguments are to be passed to cl65.
     shift 2
 
+    cell_width=${CELL_WIDTH:-8}
+    if [ 8 != "$cell_width" ] && [ 16 != "$cell_width" ]; then
+        echo "ERROR: CELL_WIDTH must be 8 or 16, not '$cell_width'" 1>&2
+        exit 1
+    fi
+
     CC=cl65
     CFLAGS=${CFLAGS:-'-Osir -Cl -Wc -W,struct-param'}
+    HOST_CC=${HOST_CC:-cc}
+    HOST_CFLAGS=${HOST_CFLAGS:-'-O2 -Wall'}
 
     # Automatically format if astyle is installed.
     set -x
@@ -143,15 +342,57 @@ if [ build = "$1" ]; then
         echo "INFO: Building for target '$target'..."
 
         load_config_for_target "$target"
+        # The memory sizes are in bytes.
+        if [ 16 = "$cell_width" ]; then
+            basicfuck_memory_size=$((basicfuck_memory_size / 2))
+        fi
+        if [ host = "$target" ]; then
+            target_cc=$HOST_CC
+            target_cflags="$HOST_CFLAGS -I host"
+            sources="$repl_source $host_source"
+        else
+            target_cc=$CC
+            target_cflags="$CFLAGS -t $target"
+            sources=$repl_source
+        fi
         # shellcheck disable=SC2089 # We want \" treated literally.
-        ALL_CFLAGS="$CFLAGS -t $target -D BASICFUCK_MEMORY_SIZE=${basicfuck_memory_size}U -D HISTORY_STACK_SIZE=${HISTORY_STACK_SIZE}U"
-        out_directory=out/$target
-        repl_out="$out_directory/${repl_source%.c}.${binary_file_extension}"
+        ALL_CFLAGS="$target_cflags -D BASICFUCK_MEMORY_SIZE=${basicfuck_memory_size}U -D HISTORY_STACK_SIZE=${HISTORY_STACK_SIZE}U -D NATIVE_MEMORY_SIZE=${native_memory_size}U -D PROGRAM_MEMORY_SIZE=${program_memory_size}U -D PROGRAM_STORE_SIZE=${program_store_size}U -D BYTECODE_CACHE_SIZE=${bytecode_cache_size}U -D TYPE_AHEAD_SIZE=${type_ahead_size}U -D CELL_WIDTH=$cell_width"
+        if [ 1 = "${ASSEMBLY_INTERPRETER:-0}" ] && [ host != "$target" ]; then
+            ALL_CFLAGS="$ALL_CFLAGS -D ASSEMBLY_INTERPRETER"
+            sources="$sources $interpreter_source"
+        fi
+        reu=0
+        if [ 1 = "${REU:-0}" ]; then
+            case $target in
+                c64|c128|host)
+                    reu=1
+                    ALL_CFLAGS="$ALL_CFLAGS -D REU" ;;
+            esac
+        fi
+        if [ 1 = "${BANKED_TAPE:-0}" ]; then
+            case $target in
+                c128|cx16|atarixl|host)
+                    ALL_CFLAGS="$ALL_CFLAGS -D BANKED_TAPE" ;;
+                # The C64 only has the REU to extend into.
+                c64)
+                    if [ 1 = "$reu" ]; then
+                        ALL_CFLAGS="$ALL_CFLAGS -D BANKED_TAPE"
+                    fi ;;
+            esac
+        fi
+        if [ 1 = "${PROFILER:-0}" ]; then
+            ALL_CFLAGS="$ALL_CFLAGS -D PROFILER"
+        fi
+        out_directory=${OUT_DIRECTORY:-out}/$target
+        repl_out="$out_directory/${repl_source%.c}${binary_file_extension:+.$binary_file_extension}"
+        if [ host != "$target" ]; then
+            ALL_CFLAGS="$ALL_CFLAGS -m $out_directory/${repl_source%.c}.map"
+        fi
 
         set -x
         mkdir -p "$out_directory"
         # shellcheck disable=SC2086,SC2090 # We want word splitting.
-        $CC $ALL_CFLAGS "$@" -o "$repl_out" "$repl_source" || exit 1
+        $target_cc $ALL_CFLAGS "$@" -o "$repl_out" $sources || exit 1
         set +x
     done
 
@@ -169,7 +410,7 @@ if [ "run" = "$1" ]; then
 
     load_config_for_target "$2"
     out_directory=out/$2
-    repl_out="$out_directory/${repl_source%.c}.${binary_file_extension}"
+    repl_out="$out_directory/${repl_source%.c}${binary_file_extension:+.$binary_file_extension}"
 
     set -x
     $emulator "$repl_out" || exit 1
@@ -178,6 +419,105 @@ if [ "run" = "$1" ]; then
     exit
 fi
 
+if [ bench = "$1" ]; then
+    if [ 2 -gt $# ]; then
+        echo 'ERROR: bench subcommand expects a target as an argument' 1>&2
+        echo "Try '$0' for more information"                           1>&2
+        exit 1
+    fi
+
+    if [ all = "$2" ]; then
+        bench_targets=$targets
+    else
+        bench_targets=$2
+    fi
+
+    # Remaining arguments are the programs to benchmark.
+    shift 2
+    if [ 0 -eq $# ]; then
+        set -- bench/*.bf
+    fi
+
+    bench_jobs=${BENCH_JOBS:-1}
+    bench_timeout=${BENCH_TIMEOUT:-600}
+
+    # Builds are done one at a time, since they share the source tree.
+    for target in $bench_targets; do
+        load_config_for_target "$target"
+        if [ -z "$bench_emulator" ]; then
+            echo "ERROR: Target '$target' can't be benchmarked" 1>&2
+            exit 1
+        fi
+
+        echo "INFO: Building benchmarks for target '$target'..."
+        "$0" build "$target" || exit 1
+        rm -rf "out/bench/$target"
+        for program in "$@"; do
+            name=$(basename "$program" .bf)
+            build_benchmark "$target" "$program" "out/bench/$target/$name"
+        done
+    done
+
+    running=0
+    for target in $bench_targets; do
+        echo "INFO: Running benchmarks for target '$target'..."
+
+        load_config_for_target "$target"
+        for program in "$@"; do
+            name=$(basename "$program" .bf)
+            run_benchmark "$target" "out/bench/$target/$name" &
+
+            running=$((running + 1))
+            if [ "$running" -ge "$bench_jobs" ]; then
+                wait
+                running=0
+            fi
+        done
+    done
+    wait
+
+    for target in $bench_targets; do
+        load_config_for_target "$target"
+        repl_out="out/$target/${repl_source%.c}${binary_file_extension:+.$binary_file_extension}"
+
+        echo
+        echo "$target: $(wc -c < "$repl_out") byte binary"
+        printf '%-20s %12s\n' PROGRAM CYCLES
+        for program in "$@"; do
+            name=$(basename "$program" .bf)
+            printf '%-20s %12s\n' "$name" \
+                   "$(print_benchmark_result "out/bench/$target/$name" "$cpu_frequency")"
+        done
+    done
+
+    exit
+fi
+
+if [ test = "$1" ]; then
+    # Remaining arguments are the sessions to test.
+    shift
+    if [ 0 -eq $# ]; then
+        set -- test/*.txt
+    fi
+
+    "$0" build host || exit 1
+
+    failed=0
+    for session in "$@"; do
+        # The banner depends on the configuration, so only what comes after
+        # the first prompt is checked.
+        if out/host/baf-repl < "$session" | sed -n '/^YOUR WILL? /,$p' \
+                | diff -u "${session%.txt}.expected" -; then
+            echo "PASS: $session"
+        else
+            echo "FAIL: $session"
+            failed=1
+        fi
+    done
+
+    exit "$failed"
+fi
+
 echo "ERROR: Unknown subcommand '$1'" 1>&2
 echo "Try '$0' for more information"  1>&2
 exit 1
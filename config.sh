@@ -16,18 +16,83 @@
 # You should have received a copy of the GNU General Public License along with
 # BASICfuck. If not, see <https://www.gnu.org/licenses/>.
 
-# The size, in bytes, of the stack used to recall previous user inputs.
-export HISTORY_STACK_SIZE=1028
+# The size, in bytes, of the stack used to recall previous user inputs. Inputs
+# are compressed, and an index of them takes another 130 bytes.
+export HISTORY_STACK_SIZE=900
 
 # The number of bytes to allocate for BASICfuck cell memory. Make this 30,000
 # cells maxiumum. If someone wants more they can always change it.
+# It is allocated from what memory is left after the REPL and its other buffers,
+# so it must shrink when they grow. If it doesn't fit, the REPL stops at startup
+# with "?OUT OF MEMORY", and says how many cells would have fit. With
+# BANKED_TAPE, linking fails instead.
 export C64_CELL_MEMORY_SIZE=30000
-export C128_CELL_MEMORY_SIZE=27750
+export C128_CELL_MEMORY_SIZE=22250
 export PLUS4_CELL_MEMORY_SIZE=30000
-export PET_CELL_MEMORY_SIZE=17000
-export CX16_CELL_MEMORY_SIZE=25250
-export ATARI_CELL_MEMORY_SIZE=25500
-export ATARIXL_CELL_MEMORY_SIZE=26250
+export PET_CELL_MEMORY_SIZE=13250
+export CX16_CELL_MEMORY_SIZE=19750
+export ATARI_CELL_MEMORY_SIZE=20000
+export ATARIXL_CELL_MEMORY_SIZE=20750
+export HOST_CELL_MEMORY_SIZE=30000
+
+# The number of bytes to allocate for natively compiled BASICfuck programs.
+# Programs whose machine code doesn't fit are run with the interpreter instead.
+export C64_NATIVE_MEMORY_SIZE=4096
+export C128_NATIVE_MEMORY_SIZE=2048
+export PLUS4_NATIVE_MEMORY_SIZE=4096
+export PET_NATIVE_MEMORY_SIZE=1024
+export CX16_NATIVE_MEMORY_SIZE=2048
+export ATARI_NATIVE_MEMORY_SIZE=2048
+export ATARIXL_NATIVE_MEMORY_SIZE=2048
+# Unused, since there is no native code generator for the host computer.
+export HOST_NATIVE_MEMORY_SIZE=0
+
+# The number of bytes to allocate for compiled BASICfuck bytecode. Programs
+# whose bytecode doesn't fit fail with "?OUT OF MEMORY".
+export C64_PROGRAM_MEMORY_SIZE=1024
+export C128_PROGRAM_MEMORY_SIZE=512
+export PLUS4_PROGRAM_MEMORY_SIZE=1024
+export PET_PROGRAM_MEMORY_SIZE=512
+export CX16_PROGRAM_MEMORY_SIZE=512
+export ATARI_PROGRAM_MEMORY_SIZE=512
+export ATARIXL_PROGRAM_MEMORY_SIZE=512
+# Jumps can only reach 64K into program memory.
+export HOST_PROGRAM_MEMORY_SIZE=65535
+
+# The number of bytes to allocate for the numbered lines of the program run with
+# RUN. Each line takes 5 bytes, plus its text, plus its bytecode.
+export C64_PROGRAM_STORE_SIZE=2048
+export C128_PROGRAM_STORE_SIZE=1024
+export PLUS4_PROGRAM_STORE_SIZE=2048
+export PET_PROGRAM_STORE_SIZE=512
+export CX16_PROGRAM_STORE_SIZE=1024
+export ATARI_PROGRAM_STORE_SIZE=1024
+export ATARIXL_PROGRAM_STORE_SIZE=1024
+export HOST_PROGRAM_STORE_SIZE=65535
+
+# The number of bytes to allocate for the compiled bytecode of recently run
+# lines, so running the same line again skips compiling it. Each line takes 5
+# bytes, plus its text, plus its bytecode. The least recently run lines are
+# dropped to make room.
+export C64_BYTECODE_CACHE_SIZE=1024
+export C128_BYTECODE_CACHE_SIZE=512
+export PLUS4_BYTECODE_CACHE_SIZE=1024
+export PET_BYTECODE_CACHE_SIZE=256
+export CX16_BYTECODE_CACHE_SIZE=512
+export ATARI_BYTECODE_CACHE_SIZE=512
+export ATARIXL_BYTECODE_CACHE_SIZE=512
+export HOST_BYTECODE_CACHE_SIZE=65535
+
+# The number of keys the type-ahead buffer holds, so keys pressed while a program
+# is busy aren't lost before `,` reads them. Must be a power of two, 256 at most.
+export C64_TYPE_AHEAD_SIZE=64
+export C128_TYPE_AHEAD_SIZE=64
+export PLUS4_TYPE_AHEAD_SIZE=64
+export PET_TYPE_AHEAD_SIZE=32
+export CX16_TYPE_AHEAD_SIZE=64
+export ATARI_TYPE_AHEAD_SIZE=32
+export ATARIXL_TYPE_AHEAD_SIZE=32
+export HOST_TYPE_AHEAD_SIZE=256
 
 # Which file extension to use for generated binaries.
 export C64_BINARY_FILE_EXTENSION=prg
@@ -37,6 +102,7 @@ export PET_BINARY_FILE_EXTENSION=prg
 export CX16_BINARY_FILE_EXTENSION=prg
 export ATARI_BINARY_FILE_EXTENSION=com
 export ATARIXL_BINARY_FILE_EXTENSION=com
+export HOST_BINARY_FILE_EXTENSION=''
 
 # Emulator commands. The binary to run will be appended to the end of the
 # command.
@@ -47,3 +113,27 @@ export PET_EMULATOR=xpet
 export CX16_EMULATOR='x16emu -rom /usr/share/x16-rom/rom.bin -prg'
 export ATARI_EMULATOR='atari800 -run'
 export ATARIXL_EMULATOR='atari800 -xl -run'
+# The host build runs directly.
+export HOST_EMULATOR=''
+
+# Emulator commands for benchmarking, which should run without waiting on the
+# user and have the first disk drive (or H: device) point at the current
+# directory. The binary to run will be appended to the end of the command.
+export C64_BENCH_EMULATOR='x64 -console -warp -sounddev dummy -virtualdev8 +drive8truedrive -device8 1 -fs8 .'
+export C128_BENCH_EMULATOR='x128 -console -warp -sounddev dummy -virtualdev8 +drive8truedrive -device8 1 -fs8 .'
+export PLUS4_BENCH_EMULATOR='xplus4 -console -warp -sounddev dummy -virtualdev8 +drive8truedrive -device8 1 -fs8 .'
+export PET_BENCH_EMULATOR='xpet -console -warp -sounddev dummy -virtualdev8 +drive8truedrive -device8 1 -fs8 .'
+export CX16_BENCH_EMULATOR='x16emu -rom /usr/share/x16-rom/rom.bin -warp -fsroot . -run -prg'
+export ATARI_BENCH_EMULATOR='atari800 -H1 . -run'
+export ATARIXL_BENCH_EMULATOR='atari800 -xl -H1 . -run'
+
+# The clock speed of each target's CPU, in hertz, used to turn the clock ticks
+# measured by benchmarks into CPU cycles. These match the PAL machines, which
+# the emulators default to.
+export C64_CPU_FREQUENCY=985248
+export C128_CPU_FREQUENCY=985248
+export PLUS4_CPU_FREQUENCY=886724
+export PET_CPU_FREQUENCY=1000000
+export CX16_CPU_FREQUENCY=8000000
+export ATARI_CPU_FREQUENCY=1773447
+export ATARIXL_CPU_FREQUENCY=1773447
@@ -0,0 +1,237 @@
+/*
+ * This file is part of BASICfuck.
+ *
+ * Copyright (c) 2024-2025 ona-li-toki-e-jan-Epiphany-tawa-mi
+ *
+ * BASICfuck is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * BASICfuck is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * BASICfuck. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Stand-in for cc65's conio, for building BASICfuck on the host computer. See
+ * conio.h.
+ */
+
+#include "conio.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <sys/ioctl.h>
+#include <sys/select.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define ESCAPE 0x1B
+
+// Terminal state.
+static bool           terminal_initialized = false;
+static bool           terminal_is_tty      = false;
+static struct termios original_terminal_settings;
+static bool           cursor_shown         = true;
+
+static void restoreTerminal(void) {
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, &original_terminal_settings);
+    if (!cursor_shown) fputs("\x1B[?25h", stdout);
+    fflush(stdout);
+}
+
+// Puts the terminal into raw mode, so keys arrive as they are pressed and
+// CTRL+C reaches the REPL as STOP. It is put back once the program exits.
+static void initializeTerminal(void) {
+    struct termios settings;
+
+    if (terminal_initialized) return;
+    terminal_initialized = true;
+
+    terminal_is_tty = isatty(STDIN_FILENO);
+    if (!terminal_is_tty) return;
+
+    tcgetattr(STDIN_FILENO, &original_terminal_settings);
+    atexit(&restoreTerminal);
+    settings = original_terminal_settings;
+    settings.c_lflag &= ~(ICANON | ECHO | ISIG | IEXTEN);
+    settings.c_iflag &= ~(ICRNL | IXON);
+    settings.c_cc[VMIN]  = 1;
+    settings.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, &settings);
+}
+
+// Returns whether input is ready to be read within the given number of
+// milliseconds.
+static bool inputReady(const int milliseconds) {
+    fd_set         descriptors;
+    struct timeval timeout;
+
+    FD_ZERO(&descriptors);
+    FD_SET(STDIN_FILENO, &descriptors);
+    timeout.tv_sec  = 0;
+    timeout.tv_usec = milliseconds * 1000;
+
+    return select(STDIN_FILENO + 1, &descriptors, NULL, NULL, &timeout) > 0;
+}
+
+// Reads a byte from stdin. Exits the program once input runs out.
+static unsigned char readByte(void) {
+    unsigned char byte = 0;
+
+    fflush(stdout);
+    if (read(STDIN_FILENO, &byte, 1) <= 0) {
+        exit(0);
+    }
+    return byte;
+}
+
+// Reads the rest of a terminal escape sequence and returns the key it stands
+// for, or 0 if it isn't one the REPL uses.
+static unsigned char readEscapeSequence(void) {
+    unsigned char byte      = 0;
+    unsigned char parameter = 0;
+
+    // A lone ESC isn't followed by anything.
+    if (!inputReady(50)) return 0;
+    byte = readByte();
+    if ('[' != byte && 'O' != byte) return 0;
+
+    byte = readByte();
+    while (byte >= '0' && byte <= '9') {
+        parameter = parameter * 10 + (byte - '0');
+        byte      = readByte();
+    }
+
+    switch (byte) {
+    case 'A': return CH_CURS_UP;
+    case 'B': return CH_CURS_DOWN;
+    case 'C': return CH_CURS_RIGHT;
+    case 'D': return CH_CURS_LEFT;
+    case 'H': return CH_HOME;
+    case 'P': return CH_F1;
+    case 'Q': return CH_F2;
+    case '~': {
+        switch (parameter) {
+        case 1:  return CH_HOME;
+        case 2:  return CH_INS;
+        case 7:  return CH_HOME;
+        case 11: return CH_F1;
+        case 12: return CH_F2;
+        default: return 0;
+        }
+    }
+    default: return 0;
+    }
+}
+
+unsigned char kbhit(void) {
+    initializeTerminal();
+    if (!terminal_is_tty) return 0;
+    return inputReady(0);
+}
+
+char cgetc(void) {
+    unsigned char key = 0;
+
+    initializeTerminal();
+
+    while (true) {
+        key = readByte();
+
+        switch (key) {
+        case '\r':
+        case '\n':
+            return CH_ENTER;
+        case '\b':
+        case 0x7F:
+            return CH_DEL;
+        // CTRL+L.
+        case 0x0C:
+            return CH_CLR;
+        case ESCAPE:
+            if (!terminal_is_tty) return key;
+            key = readEscapeSequence();
+            if (0 != key) return key;
+            break;
+        default:
+            return key;
+        }
+    }
+}
+
+void clrscr(void) {
+    fputs("\x1B[2J\x1B[H", stdout);
+}
+
+unsigned char cursor(const unsigned char onoff) {
+    const bool was_shown = cursor_shown;
+
+    cursor_shown = onoff;
+    if (isatty(STDOUT_FILENO)) {
+        fputs(onoff ? "\x1B[?25h" : "\x1B[?25l", stdout);
+    }
+
+    return was_shown;
+}
+
+void screensize(unsigned char* x, unsigned char* y) {
+    struct winsize size;
+
+    if (0 != ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) || 0 == size.ws_col) {
+        size.ws_col = 80;
+        size.ws_row = 24;
+    }
+
+    *x = size.ws_col > 255 ? 255 : size.ws_col;
+    *y = size.ws_row > 255 ? 255 : size.ws_row;
+}
+
+#undef putchar
+int conioPutchar(const int character) {
+    switch ((unsigned char)character) {
+    case CH_CURS_UP:    fputs("\x1B[A", stdout);        break;
+    case CH_CURS_DOWN:  fputs("\x1B[B", stdout);        break;
+    case CH_CURS_RIGHT: fputs("\x1B[C", stdout);        break;
+    case CH_CURS_LEFT:  fputs("\x1B[D", stdout);        break;
+    // Deletes the character to the left, shifting the rest of the line over.
+    case CH_DEL:        fputs("\x1B[D\x1B[P", stdout);  break;
+    // Inserts a space, shifting the rest of the line over.
+    case CH_INS:        fputs("\x1B[@", stdout);        break;
+    case CH_HOME:       fputs("\x1B[H", stdout);        break;
+    case CH_CLR:        clrscr();                       break;
+    default:            return putchar(character);
+    }
+
+    return character;
+}
+
+char* utoa(const unsigned int value, char* const buffer, const int radix) {
+    return ultoa(value, buffer, radix);
+}
+
+char* ultoa(unsigned long value, char* const buffer, const int radix) {
+    static const char digits[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    char* start = buffer;
+    char* end   = buffer;
+    char  swap  = 0;
+
+    do {
+        *(end++) = digits[value % radix];
+        value   /= radix;
+    } while (0 != value);
+    *end = '\0';
+
+    // Digits were written least significant first.
+    for (--end; start < end; ++start, --end) {
+        swap   = *start;
+        *start = *end;
+        *end   = swap;
+    }
+
+    return buffer;
+}
@@ -0,0 +1,67 @@
+/*
+ * This file is part of BASICfuck.
+ *
+ * Copyright (c) 2024-2025 ona-li-toki-e-jan-Epiphany-tawa-mi
+ *
+ * BASICfuck is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * BASICfuck is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * BASICfuck. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Stand-in for cc65's conio.h, for building BASICfuck on the host computer.
+ *
+ * Runs the console through an ANSI terminal. Keys are translated into the
+ * PETSCII control codes below, and those same codes are translated back into
+ * escape sequences when printed, so the REPL can edit lines the same way it
+ * does on a Commodore.
+ *
+ * When stdin is not a terminal, input is read as-is and STOP is never pressed,
+ * so programs can be piped in.
+ */
+
+#ifndef HOST_CONIO_H
+#define HOST_CONIO_H
+
+#include <stdio.h>
+
+#define CH_CURS_UP    0x91
+#define CH_CURS_DOWN  0x11
+#define CH_CURS_LEFT  0x9D
+#define CH_CURS_RIGHT 0x1D
+#define CH_DEL        0x14
+#define CH_INS        0x94
+#define CH_ENTER      '\n'
+#define CH_STOP       0x03
+#define CH_HOME       0x13
+#define CH_CLR        0x93
+#define CH_F1         0x85
+#define CH_F2         0x89
+
+// Returns whether a key has been pressed.
+unsigned char kbhit(void);
+// Awaits a key from the keyboard. Exits the program once input runs out.
+char cgetc(void);
+void clrscr(void);
+// Shows or hides the cursor. Returns whether it was shown before.
+unsigned char cursor(unsigned char onoff);
+void screensize(unsigned char* x, unsigned char* y);
+
+// Prints a character, translating control codes into escape sequences.
+int conioPutchar(int character);
+#undef putchar
+#define putchar(character) conioPutchar(character)
+
+// Not part of conio.h, but cc65 has them and the host C library doesn't.
+char* utoa(unsigned int value, char* buffer, int radix);
+char* ultoa(unsigned long value, char* buffer, int radix);
+
+#endif // HOST_CONIO_H